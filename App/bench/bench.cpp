@@ -0,0 +1,442 @@
+#include <memory>
+#include <random>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <filesystem>
+#include <benchmark/benchmark.h>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "window.h"
+#include "shader.h"
+#include "camera.h"
+#include "model.h"
+#include "modelData.h"
+#include "image.h"
+#include "fontData.h"
+#include "fileView.h"
+#include "textRenderer.h"
+#include "textLayout.h"
+#include "frustum.h"
+#include "utf8.h"
+#include "frameArena.h"
+#include "jobSystem.h"
+#include "startupReport.h"
+
+
+// microbenchmarks of the engine's hot paths; every case that doesn't need
+// an OpenGL context runs a second time with one current (the ...GL
+// variants, skipped when no context can be created or with --no-gl), so
+// the cost of a context (driver threads, its state) shows in comparison;
+// text layout, model drawing and uniforms are GL calls, they only run with
+// a context; the context is a headless window, so llvmpipe does on
+// machines without a GPU
+//
+// assets are read as loose files relative to APP_BENCH_SOURCE_DIR (the App
+// directory), so the benchmarks don't depend on cooked outputs or the pack
+namespace
+{
+	const char* const modelPaths[] = {
+		"resources/objects/container/container.obj",
+		"resources/objects/lamp/lamp.obj",
+		"resources/objects/backpack/backpack.obj"
+	};
+
+	const char* const imagePaths[] = {
+		"resources/objects/container/container.png",
+		"resources/objects/backpack/ao.jpg"
+	};
+
+	const char* const fontPath = "resources/font/consola.ttf";
+
+	const std::string text =
+		"The quick brown fox jumps over the lazy dog. 0123456789 "
+		"Sphinx of black quartz, judge my vow! (x + y) * z = 42; "
+		"\xC3\xA4\xC3\xB6\xC3\xBC \xE2\x82\xAC \xCE\xB1\xCE\xB2\xCE\xB3";
+
+	bool noGL = false;
+	std::unique_ptr<Window> context;
+
+	// created on first use, stays current for the whole run
+	Window* getContext(benchmark::State& state)
+	{
+		if (!context && !noGL)
+		{
+			try { context = std::make_unique<Window>(800, 800, "app_bench", false, false, true); }
+			catch (const std::runtime_error& error)
+			{
+				std::cerr << error.what();
+				noGL = true;
+			}
+		}
+
+		if (!context)
+			state.SkipWithError("no OpenGL context");
+
+		return context.get();
+	}
+
+	std::vector<AABB> randomBoxes(std::size_t count)
+	{
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+		std::vector<AABB> boxes(count);
+		for (AABB& box : boxes)
+		{
+			glm::vec3 min(position(random), position(random), position(random));
+			box.min = min;
+			box.max = min + glm::vec3(size(random), size(random), size(random));
+		}
+
+		return boxes;
+	}
+
+	// runs a case that doesn't need a context with one current
+	void withGL(benchmark::State& state, void (*function)(benchmark::State&))
+	{
+		if (getContext(state) == nullptr)
+			return;
+
+		function(state);
+	}
+}
+
+// models
+
+static void BM_ModelImport(benchmark::State& state)
+{
+	const char* path = modelPaths[state.range(0)];
+	state.SetLabel(path);
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(ModelData::import(path));
+}
+BENCHMARK(BM_ModelImport)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+static void BM_ModelImportGL(benchmark::State& state)
+{
+	withGL(state, BM_ModelImport);
+}
+BENCHMARK(BM_ModelImportGL)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+static void BM_ModelLoadGL(benchmark::State& state)
+{
+	const char* path = modelPaths[state.range(0)];
+	state.SetLabel(path);
+
+	if (getContext(state) == nullptr)
+		return;
+
+	// the constructor doesn't share the model through the registry, every
+	// iteration imports (or reads the cooked data) and uploads again
+	for (auto _ : state)
+	{
+		Model model(path);
+		glFinish();
+	}
+}
+BENCHMARK(BM_ModelLoadGL)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+// images
+
+static void BM_ImageDecode(benchmark::State& state)
+{
+	const char* path = imagePaths[state.range(0)];
+	state.SetLabel(path);
+
+	for (auto _ : state)
+	{
+		Image image(path);
+		benchmark::DoNotOptimize(image.getData());
+	}
+}
+BENCHMARK(BM_ImageDecode)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+static void BM_ImageDecodeGL(benchmark::State& state)
+{
+	withGL(state, BM_ImageDecode);
+}
+BENCHMARK(BM_ImageDecodeGL)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+static void BM_ImageConvert(benchmark::State& state)
+{
+	const char* path = imagePaths[state.range(0)];
+	state.SetLabel(path);
+
+	Image source(path);
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		Image image = source;
+		state.ResumeTiming();
+
+		image.convert(IL_RGBA, IL_UNSIGNED_BYTE);
+		benchmark::DoNotOptimize(image.getData());
+	}
+}
+BENCHMARK(BM_ImageConvert)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+static void BM_ImageConvertGL(benchmark::State& state)
+{
+	withGL(state, BM_ImageConvert);
+}
+BENCHMARK(BM_ImageConvertGL)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+static void BM_ImageFlip(benchmark::State& state)
+{
+	const char* path = imagePaths[state.range(0)];
+	state.SetLabel(path);
+
+	Image image(path);
+
+	for (auto _ : state)
+	{
+		image.flip();
+		benchmark::DoNotOptimize(image.getData());
+	}
+}
+BENCHMARK(BM_ImageFlip)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+static void BM_ImageFlipGL(benchmark::State& state)
+{
+	withGL(state, BM_ImageFlip);
+}
+BENCHMARK(BM_ImageFlipGL)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+// text
+
+static void BM_TextDecode(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		char32_t sum = 0;
+		for (std::size_t pos = 0; pos < text.size();)
+			sum += decodeUtf8(text, pos);
+
+		benchmark::DoNotOptimize(sum);
+	}
+
+	state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_TextDecode);
+
+static void BM_TextDecodeGL(benchmark::State& state)
+{
+	withGL(state, BM_TextDecode);
+}
+BENCHMARK(BM_TextDecodeGL);
+
+static void BM_FontRasterize(benchmark::State& state)
+{
+	FileView font(fontPath);
+	FontData::Mode mode = state.range(0) == 0 ? FontData::BITMAP : FontData::SDF;
+	state.SetLabel(mode == FontData::BITMAP ? "bitmap" : "sdf");
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(FontData::rasterize(font, 0, 30, mode, 1));
+}
+BENCHMARK(BM_FontRasterize)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+static void BM_FontRasterizeGL(benchmark::State& state)
+{
+	withGL(state, BM_FontRasterize);
+}
+BENCHMARK(BM_FontRasterizeGL)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+// shapes and batches the string every iteration (arg 0) or only once into
+// a layout (arg 1), drawn by endFrame()
+static void BM_TextLayoutGL(benchmark::State& state)
+{
+	if (getContext(state) == nullptr)
+		return;
+
+	bool cached = state.range(0) != 0;
+	state.SetLabel(cached ? "layout" : "immediate");
+
+	Shader shader("src/shader/text.vert", "src/shader/text.frag");
+	TextRenderer textRenderer(fontPath, 0, 30);
+	TextLayout layout;
+
+	for (auto _ : state)
+	{
+		if (cached)
+			textRenderer.renderText(shader, layout, text, 0.0f, 0.0f);
+		else
+			textRenderer.renderText(shader, text, 0.0f, 0.0f);
+
+		textRenderer.endFrame();
+		glFlush();
+
+		// every iteration is a frame, as far as the frame arena is concerned
+		FrameArena::nextFrame();
+	}
+}
+BENCHMARK(BM_TextLayoutGL)->DenseRange(0, 1);
+
+// culling and matrices
+
+static void BM_FrustumCull(benchmark::State& state)
+{
+	std::vector<AABB> boxes = randomBoxes(static_cast<std::size_t>(state.range(0)));
+	std::vector<std::uint32_t> visible;
+	visible.reserve(boxes.size());
+
+	Camera camera(glm::vec3(0.0f, 0.0f, 60.0f));
+	Frustum frustum(camera.getProjMatrix(800.0f, 800.0f) * camera.getViewMatrix());
+
+	for (auto _ : state)
+	{
+		visible.clear();
+		benchmark::DoNotOptimize(frustum.cull(boxes, visible));
+	}
+
+	state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BM_FrustumCull)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+static void BM_FrustumCullGL(benchmark::State& state)
+{
+	withGL(state, BM_FrustumCull);
+}
+BENCHMARK(BM_FrustumCullGL)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+static void BM_ModelMatrix(benchmark::State& state)
+{
+	glm::vec3 pos(1.0f, 2.0f, 3.0f);
+	float angle = 0.0f;
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Model::getModelMatrix(pos, 0.25f, glm::vec3(0.0f, 1.0f, 0.0f), angle));
+		angle += 1.0f;
+	}
+}
+BENCHMARK(BM_ModelMatrix);
+
+static void BM_ModelMatrixGL(benchmark::State& state)
+{
+	withGL(state, BM_ModelMatrix);
+}
+BENCHMARK(BM_ModelMatrixGL);
+
+static void BM_CameraViewMatrix(benchmark::State& state)
+{
+	Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(camera.getViewMatrix());
+}
+BENCHMARK(BM_CameraViewMatrix);
+
+static void BM_CameraViewMatrixGL(benchmark::State& state)
+{
+	withGL(state, BM_CameraViewMatrix);
+}
+BENCHMARK(BM_CameraViewMatrixGL);
+
+// everything Model::draw() does: matrix, uniforms, texture binds and draws
+static void BM_ModelDrawGL(benchmark::State& state)
+{
+	const char* path = modelPaths[state.range(0)];
+	state.SetLabel(path);
+
+	if (getContext(state) == nullptr)
+		return;
+
+	Shader shader("src/shader/main.vert", "src/shader/main.frag");
+	Model model(path);
+
+	for (auto _ : state)
+	{
+		model.draw(shader, glm::vec3(0.0f), 1.0f);
+		glFlush();
+		FrameArena::nextFrame();
+	}
+}
+BENCHMARK(BM_ModelDrawGL)->DenseRange(0, 2);
+
+// uniforms
+
+// the uniforms main sets per frame; arg 0 sets them by name (the shader
+// caches the locations), arg 1 only looks the locations up in the driver
+static void BM_UniformsGL(benchmark::State& state)
+{
+	if (getContext(state) == nullptr)
+		return;
+
+	Shader shader("src/shader/main.vert", "src/shader/main.frag");
+	Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+	shader.useProgram();
+
+	bool lookupOnly = state.range(0) != 0;
+	state.SetLabel(lookupOnly ? "lookup" : "set");
+
+	const char* const names[] = {
+		"viewPos", "light.position", "light.ambient", "light.diffuse",
+		"light.specular", "material.shininess", "view", "projection"
+	};
+
+	for (auto _ : state)
+	{
+		if (lookupOnly)
+		{
+			GLuint program = 0;
+			glGetIntegerv(GL_CURRENT_PROGRAM, reinterpret_cast<GLint*>(&program));
+
+			for (const char* name : names)
+				benchmark::DoNotOptimize(glGetUniformLocation(program, name));
+		}
+		else
+		{
+			shader.setUniform3f("viewPos", 0.0f, 0.0f, 3.0f);
+			shader.setUniform3f("light.position", 1.0f, 0.0f, 3.0f);
+			shader.setUniform3f("light.ambient", 0.1f, 0.1f, 0.1f);
+			shader.setUniform3f("light.diffuse", 0.5f, 0.5f, 0.5f);
+			shader.setUniform3f("light.specular", 1.0f, 1.0f, 1.0f);
+			shader.setUniform1f("material.shininess", 64.0f);
+			camera.applyTransformation(shader, 800.0f, 800.0f);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * std::size(names));
+}
+BENCHMARK(BM_UniformsGL)->DenseRange(0, 1);
+
+int main(int argC, char* argV[])
+{
+	// --no-gl skips the cases that need an OpenGL context
+	for (int i = 1; i < argC; i++)
+	{
+		if (std::string(argV[i]) == "--no-gl")
+			noGL = true;
+	}
+
+	benchmark::Initialize(&argC, argV);
+
+	std::filesystem::current_path(APP_BENCH_SOURCE_DIR);
+	Image::exceptions(true);
+
+	// the loads measured aren't part of a startup, they mustn't pay for
+	// recording it
+	StartupReport::finish();
+
+	// the pool the app runs with, large culling sets use it
+	JobSystem::start();
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	JobSystem::stop();
+
+	// the context has to be gone before GLFW is
+	context.reset();
+
+	return 0;
+}
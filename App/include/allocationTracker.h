@@ -0,0 +1,113 @@
+#pragma once
+
+// counts heap allocations (global operator new) per frame and per tag, the
+// tag being the innermost ALLOCATION_SCOPE of the allocating thread;
+// allocations outside of any scope are counted as "untagged"
+//
+// allocations in hot scopes (ALLOCATION_HOT_SCOPE) are violations, in
+// assert mode the first one aborts the process with the scope's name, so
+// a test fails as soon as a hot path allocates
+//
+// the tracker only exists when the engine is built with
+// APP_ENABLE_ALLOCATION_TRACKING (CMake option of the same name), otherwise
+// the ALLOCATION_ macros expand to nothing and operator new isn't replaced
+#ifdef APP_ENABLE_ALLOCATION_TRACKING
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+
+class AllocationTracker
+{
+public:
+	enum Mode
+	{
+		NORMAL,
+		HOT
+	};
+
+	struct Counters
+	{
+		std::uint64_t allocations;
+		std::uint64_t bytes;
+	};
+
+	// returns the tag of the name, registering it on first use; names have
+	// to be string literals (or outlive the tracker), at most maxTags
+	// names exist, further ones share the last tag
+	static int tag(const char* name);
+
+	class Scope
+	{
+	public:
+		explicit Scope(int tag, Mode mode = NORMAL);
+		~Scope();
+
+		Scope(const Scope& other) = delete;
+		Scope& operator=(const Scope& other) = delete;
+
+	private:
+		int previousTag;
+		int previousHotTag;
+	};
+
+	// called by the replaced operator new, from any thread
+	static void record(std::size_t size);
+
+	// latches the counters of the frame that ended and resets them; has to be
+	// called once per frame by the main thread
+	static void frame();
+
+	static void setAssertMode(bool enabled);
+	static std::uint64_t getHotViolations();
+
+	static Counters getLastFrame();
+	static Counters getLastFrame(int tag);
+
+	// allocations and bytes per tag of the last frame, on average per frame
+	// and in total
+	static void print(std::ostream& stream);
+
+private:
+	static constexpr int maxTags = 32;
+
+	struct AtomicCounters
+	{
+		std::atomic<std::uint64_t> allocations;
+		std::atomic<std::uint64_t> bytes;
+	};
+
+	static std::array<const char*, maxTags> names;
+	static std::atomic<int> tagCount;
+
+	static std::array<AtomicCounters, maxTags> counters;
+	static std::array<Counters, maxTags> lastFrame;
+	static std::array<Counters, maxTags> total;
+	static std::uint64_t frameCount;
+
+	static std::atomic<bool> assertMode;
+	static std::atomic<std::uint64_t> hotViolations;
+};
+
+#define ALLOCATION_CONCAT_IMPL(a, b) a##b
+#define ALLOCATION_CONCAT(a, b) ALLOCATION_CONCAT_IMPL(a, b)
+
+// the tag is looked up once per call site
+#define ALLOCATION_SCOPE_IMPL(name, mode) \
+	static const int ALLOCATION_CONCAT(allocationTag, __LINE__) = AllocationTracker::tag(name); \
+	AllocationTracker::Scope ALLOCATION_CONCAT(allocationScope, __LINE__)(ALLOCATION_CONCAT(allocationTag, __LINE__), mode)
+
+#define ALLOCATION_SCOPE(name) ALLOCATION_SCOPE_IMPL(name, AllocationTracker::NORMAL)
+#define ALLOCATION_HOT_SCOPE(name) ALLOCATION_SCOPE_IMPL(name, AllocationTracker::HOT)
+#define ALLOCATION_FRAME() AllocationTracker::frame()
+
+#else
+
+#define ALLOCATION_SCOPE(name) ((void)0)
+#define ALLOCATION_HOT_SCOPE(name) ((void)0)
+#define ALLOCATION_FRAME() ((void)0)
+
+#endif
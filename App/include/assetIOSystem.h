@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include "fileView.h"
+
+
+// assimp IOStream reading from a FileView, assimp copies directly from
+// the mapping (or the decompressed pack entry) into its own buffers
+class AssetIOStream : public Assimp::IOStream
+{
+public:
+	AssetIOStream(FileView&& view);
+
+	std::size_t Read(void* buffer, std::size_t size, std::size_t count) override;
+	std::size_t Write(const void* buffer, std::size_t size, std::size_t count) override;
+	aiReturn Seek(std::size_t offset, aiOrigin origin) override;
+	std::size_t Tell() const override;
+	std::size_t FileSize() const override;
+	void Flush() override;
+
+private:
+	FileView view;
+	std::size_t pos;
+};
+
+// assimp IOSystem handing out AssetIOStreams opened through Assets, used
+// for the imported file itself and every file it references (.mtl files
+// for example), so models can be imported from an asset pack as well
+class AssetIOSystem : public Assimp::IOSystem
+{
+public:
+	bool Exists(const char* file) const override;
+	char getOsSeparator() const override;
+	Assimp::IOStream* Open(const char* file, const char* mode = "rb") override;
+	void Close(Assimp::IOStream* file) override;
+
+	// every file successfully opened so far, in order of opening
+	const std::vector<std::string>& getOpenedFiles() const;
+
+private:
+	std::vector<std::string> openedFiles;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+
+#include "fileView.h"
+#include "compression.h"
+
+
+// single-file archive of assets with a hash index sorted by the xxHash of
+// the normalized asset path; every entry is compressed individually, so
+// entries can be read without touching the rest of the pack
+//
+// layout:	header | entry data (16 byte aligned) | index | path strings
+class AssetPack
+{
+public:
+	AssetPack(const std::filesystem::path& packPath);
+
+	bool contains(const std::filesystem::path& path) const;
+
+	// uncompressed entries refer directly to the mapped pack,
+	// compressed entries are decompressed into an owned buffer
+	FileView open(
+		const std::filesystem::path& path,
+		FileView::Access access = FileView::SEQUENTIAL
+	) const;
+
+	std::size_t getEntryCount() const;
+	const std::filesystem::path& getPath() const;
+
+	// a file on disk and the path it is stored under in the pack
+	struct Input
+	{
+		std::filesystem::path file;
+		std::filesystem::path path;
+	};
+
+	// an entry is stored uncompressed if compression doesn't save at
+	// least 5 percent
+	static void build(
+		const std::filesystem::path& packPath,
+		const std::vector<Input>& inputs,
+		Compression::Codec codec = Compression::ZSTD,
+		int level = 0
+	);
+
+	// generic, lexically normal form of a relative path ("a/./b" -> "a/b")
+	static std::string normalize(const std::filesystem::path& path);
+
+private:
+	struct Header
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t entryCount;
+		std::uint64_t indexOffset;
+		std::uint64_t stringsOffset;
+		std::uint64_t stringsSize;
+	};
+
+	struct Entry
+	{
+		std::uint64_t hash;
+		std::uint64_t offset;
+		std::uint64_t size;
+		std::uint64_t originalSize;
+		std::uint32_t pathOffset;
+		std::uint32_t pathLength;
+		std::uint8_t codec;
+		std::uint8_t reserved[7];
+	};
+
+	static constexpr char packMagic[4] = { 'A', 'P', 'A', 'K' };
+	static constexpr std::uint32_t packVersion = 1;
+
+	std::shared_ptr<const FileView> file;
+
+	const Header* header;
+	const Entry* entries;
+	const char* strings;
+
+	const Entry* find(const std::string& key) const;
+};
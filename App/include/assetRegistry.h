@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <filesystem>
+#include <unordered_map>
+
+
+// process-wide registry of loaded assets (textures, meshes and models), so
+// an asset that is requested several times is loaded and uploaded once and
+// shared by all users
+//
+// the registry only holds weak references: an asset is released as soon as
+// its last user drops it and is loaded again when it is requested next time
+//
+// assets are keyed by their normalized path and the hash of their content,
+// so a changed file is never mistaken for the loaded one
+class AssetRegistry
+{
+public:
+	enum Type
+	{
+		TEXTURE,
+		MESH,
+		MODEL
+	};
+
+	struct Info
+	{
+		Type type;
+		std::string path;
+		std::uint64_t contentHash;
+		long useCount;
+		std::size_t memorySize;
+	};
+
+	// returns the registered asset or the one created by create(), which is
+	// called without holding the registry lock, so it may acquire other
+	// assets itself; T needs a getMemorySize() const method
+	template <typename T, typename Factory>
+	static std::shared_ptr<T> acquire(
+		Type type,
+		std::string_view path,
+		std::uint64_t contentHash,
+		Factory&& create
+	);
+
+	// hash of the content of an asset file, 0 if it doesn't exist
+	static std::uint64_t contentHash(const std::filesystem::path& path);
+
+	// live assets only, released ones are skipped
+	static std::vector<Info> getInfo();
+	static void printInfo(std::ostream& stream);
+
+	static const char* toString(Type type);
+
+private:
+	struct Record
+	{
+		Type type;
+		std::string path;
+		std::uint64_t contentHash;
+		std::weak_ptr<const void> asset;
+		std::size_t (*memorySize)(const void* asset);
+	};
+
+	static std::mutex mutex;
+	static std::unordered_map<std::uint64_t, Record> records;
+
+	static std::uint64_t key(Type type, std::string_view path, std::uint64_t contentHash);
+	// a record under the key that isn't the asset asked for (a collision of
+	// the key) is a miss
+	static std::shared_ptr<const void> find(std::uint64_t key, Type type, std::string_view path, std::uint64_t contentHash);
+	static std::shared_ptr<const void> insert(std::uint64_t key, Record&& record, std::shared_ptr<const void> asset);
+};
+
+template <typename T, typename Factory>
+std::shared_ptr<T> AssetRegistry::acquire(
+	Type type,
+	std::string_view path,
+	std::uint64_t contentHash,
+	Factory&& create
+)
+{
+	std::uint64_t assetKey = key(type, path, contentHash);
+
+	// assets are stored const, but handed out as they were created
+	if (std::shared_ptr<const void> asset = find(assetKey, type, path, contentHash))
+		return std::const_pointer_cast<T>(std::static_pointer_cast<const T>(asset));
+
+	std::shared_ptr<T> asset = create();
+
+	Record record = {
+		type,
+		std::string(path),
+		contentHash,
+		{},
+		[](const void* asset) -> std::size_t { return static_cast<const T*>(asset)->getMemorySize(); }
+	};
+
+	// another thread may have registered the same asset in the meantime,
+	// in that case the registered one wins and the created one is dropped
+	std::shared_ptr<const void> registered = insert(assetKey, std::move(record), asset);
+	return std::const_pointer_cast<T>(std::static_pointer_cast<const T>(registered));
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <memory>
+#include <filesystem>
+
+#include "fileView.h"
+#include "assetPack.h"
+
+
+// entry point for all asset reads; paths are looked up in the mounted
+// asset pack first and fall back to loose files on disk, so loose files
+// can be used during development by simply not mounting a pack
+class Assets
+{
+public:
+	static void mountPack(const std::filesystem::path& packPath);
+	static void unmountPack();
+	static bool isPackMounted();
+
+	static bool exists(const std::filesystem::path& path);
+	static FileView open(
+		const std::filesystem::path& path,
+		FileView::Access access = FileView::SEQUENTIAL
+	);
+
+private:
+	static std::unique_ptr<AssetPack> pack;
+};
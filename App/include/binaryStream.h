@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+
+// minimal helpers to (de)serialize trivially copyable values, strings and
+// vectors of trivially copyable values in native byte order
+class BinaryWriter
+{
+public:
+	template <typename T>
+	void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		append(&value, sizeof(T));
+	}
+
+	void writeString(std::string_view str)
+	{
+		write<std::uint32_t>(static_cast<std::uint32_t>(str.size()));
+		append(str.data(), str.size());
+	}
+
+	template <typename T>
+	void writeVector(const std::vector<T>& vec)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		write<std::uint64_t>(vec.size());
+		append(vec.data(), vec.size() * sizeof(T));
+	}
+
+	std::vector<std::byte>& data()
+	{
+		return buffer;
+	}
+
+private:
+	std::vector<std::byte> buffer;
+
+	void append(const void* data, std::size_t size)
+	{
+		if (size == 0)
+			return;
+
+		std::size_t offset = buffer.size();
+		buffer.resize(offset + size);
+		std::memcpy(buffer.data() + offset, data, size);
+	}
+};
+
+class BinaryReader
+{
+public:
+	BinaryReader(const std::byte* data, std::size_t size)
+		: data{ data }
+		, size{ size }
+		, pos{ 0 }
+	{
+
+	}
+
+	template <typename T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		T value;
+		extract(&value, sizeof(T));
+		return value;
+	}
+
+	std::string readString()
+	{
+		std::uint32_t length = read<std::uint32_t>();
+
+		if (length > size - pos)
+			throw std::runtime_error("Error: BinaryReader::readString(): Unexpected end of data.\n");
+
+		std::string str(length, '\0');
+		extract(str.data(), str.size());
+		return str;
+	}
+
+	template <typename T>
+	std::vector<T> readVector()
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		std::size_t count = readCount(sizeof(T));
+
+		std::vector<T> vec(count);
+		extract(vec.data(), count * sizeof(T));
+		return vec;
+	}
+
+	// element count of what follows, checked against the data left (each
+	// element takes at least elementSize bytes) before anything is allocated
+	std::size_t readCount(std::size_t elementSize)
+	{
+		std::uint64_t count = read<std::uint64_t>();
+
+		if (count > (size - pos) / (elementSize > 0 ? elementSize : 1))
+			throw std::runtime_error("Error: BinaryReader::readCount(): Unexpected end of data.\n");
+
+		return static_cast<std::size_t>(count);
+	}
+
+	bool atEnd() const
+	{
+		return pos == size;
+	}
+
+private:
+	const std::byte* data;
+	std::size_t size;
+	std::size_t pos;
+
+	void extract(void* dst, std::size_t count)
+	{
+		if (count > size - pos)
+			throw std::runtime_error("Error: BinaryReader::read(): Unexpected end of data.\n");
+
+		if (count > 0)
+			std::memcpy(dst, data + pos, count);
+
+		pos += count;
+	}
+};
@@ -70,6 +70,12 @@ private:
 	GLfloat speedMultiplicator;
 	GLfloat sensitivity;
 
+	// cursor position of the previous cursor event, turning starts with the
+	// second one
+	bool cursorKnown;
+	GLfloat lastCursorX;
+	GLfloat lastCursorY;
+
 	void setCoordinateSystem(const glm::vec3& zAxis);
 	
 	void move(Direction direction);
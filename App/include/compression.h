@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+class Compression
+{
+public:
+	enum Codec : std::uint8_t
+	{
+		NONE = 0,
+		LZ4 = 1,
+		ZSTD = 2
+	};
+
+	// level 0 selects the default level of the codec, for LZ4 any level
+	// above 0 selects the (slower, stronger) HC compressor
+	static std::vector<std::byte> compress(
+		Codec codec,
+		const std::byte* data, std::size_t size,
+		int level = 0
+	);
+
+	// dstSize must be the exact size of the uncompressed data
+	static void decompress(
+		Codec codec,
+		const std::byte* src, std::size_t srcSize,
+		std::byte* dst, std::size_t dstSize
+	);
+
+	// largest size srcSize bytes of compressed data can decompress to, to
+	// check sizes read from files before allocating; 0 when the data can't
+	// be valid (Zstd data has to record its content size, which compress()
+	// does)
+	static std::uint64_t decompressBound(
+		Codec codec,
+		const std::byte* src, std::size_t srcSize
+	);
+
+	static std::string toString(Codec codec);
+	static Codec fromString(const std::string& str);
+};
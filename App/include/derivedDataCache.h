@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <ostream>
+#include <filesystem>
+#include <span>
+
+#include "fileView.h"
+
+
+// cache for data derived from assets (cooked meshes, textures and fonts,
+// program binaries, ...), shared by all loaders and the cooker, see
+// tools/cooker.cpp
+//
+// an entry is identified by a key derived from the content of its sources
+// and the parameters they were processed with, so an outdated entry is
+// never used: it simply isn't found anymore when a source changes
+//
+// entries are written atomically (to a temporary file that is renamed),
+// so a crash never leaves a truncated entry behind; when the entries in
+// the cache directory exceed the size limit, the least recently used ones
+// are evicted
+class DerivedDataCache
+{
+public:
+	struct Statistics
+	{
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t stores = 0;
+		std::uint64_t evictions = 0;
+		std::uint64_t bytesLoaded = 0;
+		std::uint64_t bytesStored = 0;
+	};
+
+	static void setDirectory(const std::filesystem::path& directory);
+	static const std::filesystem::path& getDirectory();
+
+	// 0 disables eviction
+	static void setSizeLimit(std::uint64_t bytes);
+	static std::uint64_t getSizeLimit();
+
+	static std::uint64_t key(const FileView& source, std::string_view params);
+	static std::uint64_t key(std::span<const FileView> sources, std::string_view params);
+	static std::filesystem::path path(std::uint64_t key, std::string_view kind);
+
+	// entries are read through Assets, so they can live in the asset pack
+	// as well; the returned view holds the decompressed data
+	static std::optional<FileView> load(std::uint64_t key, std::string_view kind);
+	// loaders call this when a loaded entry turns out to be corrupt (it
+	// doesn't deserialize), the hit is counted as a miss instead
+	static void reject(std::string_view kind);
+
+	// loaders store what they produced on a miss, so the next run hits;
+	// they ignore a failing store (like a read-only install directory),
+	// which only means the work is done again next time
+	static void store(std::uint64_t key, std::string_view kind, const std::vector<std::byte>& data);
+
+	// statistics of all kinds, accumulated since startup
+	static std::map<std::string, Statistics> getStatistics();
+	static void printStatistics(std::ostream& stream);
+
+private:
+	struct Header
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t key;
+		std::uint64_t size;
+		std::uint8_t codec;
+		std::uint8_t reserved[7];
+	};
+
+	struct Entry
+	{
+		std::uint64_t size;
+		std::filesystem::file_time_type lastAccess;
+	};
+
+	static constexpr char cacheMagic[4] = { 'C', 'O', 'O', 'K' };
+	static constexpr std::uint32_t cacheVersion = 1;
+
+	static std::filesystem::path directory;
+	static std::uint64_t sizeLimit;
+
+	// entries in the cache directory, scanned on first use
+	static std::mutex mutex;
+	static std::map<std::filesystem::path, Entry> entries;
+	static std::uint64_t totalSize;
+	static bool scanned;
+
+	static std::map<std::string, Statistics, std::less<>> statistics;
+
+	static void scan();
+	static void touch(const std::filesystem::path& entryPath);
+	static void evict(const std::filesystem::path& keep);
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <filesystem>
+
+
+// read-only, memory-mapped view of a whole file; the mapped bytes stay
+// valid for the lifetime of the view and can be handed to decoders
+// directly without copying them into intermediate buffers
+//
+// a view can also refer to a range inside another (shared) view, which is
+// how uncompressed entries of an asset pack are handed out, or own a
+// buffer, which is how decompressed entries are handed out
+class FileView
+{
+public:
+	// access pattern hint passed to the OS (madvise on linux)
+	enum Access
+	{
+		SEQUENTIAL,
+		RANDOM,
+		WILLNEED
+	};
+
+	FileView();
+	FileView(const std::filesystem::path& path, Access access = SEQUENTIAL);
+	FileView(
+		std::shared_ptr<const FileView> parent,
+		std::size_t offset, std::size_t size,
+		const std::filesystem::path& path
+	);
+	FileView(std::vector<std::byte>&& buffer, const std::filesystem::path& path);
+
+	FileView(const FileView& other) = delete;
+	FileView(FileView&& other) noexcept;
+	~FileView();
+
+	FileView& operator=(const FileView& other) = delete;
+	FileView& operator=(FileView&& other) noexcept;
+
+	const std::byte* data() const;
+	std::size_t size() const;
+	bool empty() const;
+
+	// view on the mapped bytes as characters, NOT null-terminated
+	std::string_view str() const;
+
+	const std::filesystem::path& getPath() const;
+
+	void advise(Access access) const;
+
+private:
+	std::filesystem::path path;
+
+	const std::byte* ptr;
+	std::size_t length;
+
+	// base address and length of the mapping, if any
+	void* mapping;
+	std::size_t mappingLength;
+
+	// keeps the mapping alive when this is a range inside another view
+	std::shared_ptr<const FileView> parent;
+
+	// owned bytes, if the view does not refer to a mapping
+	std::vector<std::byte> buffer;
+
+	void unmap();
+};
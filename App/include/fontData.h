@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <glm/glm.hpp>
+
+#include "fileView.h"
+
+
+// CPU side result of rasterizing the first 128 ASCII glyphs of a font at a
+// fixed pixel size; this is what the cooker stores and what TextRenderer
+// uploads
+//
+// SDF glyphs hold signed distances to the outline instead of coverage
+// (128 on the outline, larger inside, sdfSpread pixels at most) and have a
+// border of sdfSpread pixels around the outline; they are rasterized once
+// at sdfSize and scaled to any size when drawn
+class FontData
+{
+public:
+	enum Mode : std::uint8_t
+	{
+		BITMAP,
+		SDF
+	};
+
+	static constexpr unsigned int sdfSize = 32;
+	static constexpr unsigned int sdfSpread = 4;
+
+	// size.x:		width in pixels of the bitmap
+	// size.y:		height in pixels of the bitmap
+	// bearing.x:	horizontal position in pixels of the bitmap relative to the origin
+	// bearing.y:	vertical position in pixels of the bitmap relative to the baseline
+	// advance:		horizontal distance in 1/64 pixels from the origin to the origin of the next glyph
+	// bitmap:		size.x * size.y coverage (or distance) values, rows without padding
+
+	struct Glyph
+	{
+		glm::uvec2 size;
+		glm::ivec2 bearing;
+		int advance;
+		std::vector<std::uint8_t> bitmap;
+	};
+
+	// how load() got the glyphs; threadCount is 0 when they were cached
+	struct LoadInfo
+	{
+		bool cached;
+		unsigned int glyphCount;
+		unsigned int threadCount;
+		double seconds;
+	};
+
+	static constexpr unsigned int glyphCount = 128;
+
+	// indexed by character code
+	std::vector<Glyph> glyphs;
+
+	// width is automatically calculated based on height when set to 0
+	static FontData load(
+		const std::filesystem::path& path,
+		unsigned int width, unsigned int height,
+		Mode mode = BITMAP,
+		LoadInfo* info = nullptr
+	);
+
+	// the glyphs are split into threadCount contiguous ranges rasterized in
+	// parallel by the job system, every range with its own FreeType library
+	// and face; threadCount 0 uses all threads of the job system
+	static FontData rasterize(
+		const FileView& font,
+		unsigned int width, unsigned int height,
+		Mode mode = BITMAP,
+		unsigned int threadCount = 0
+	);
+
+	std::vector<std::byte> serialize() const;
+	static FontData deserialize(const FileView& data);
+	// empty instead of throwing when the data is corrupt
+	static std::optional<FontData> tryDeserialize(const FileView& data);
+
+	// identifies pixel size, mode and format version, part of the cooked key
+	static std::string params(unsigned int width, unsigned int height, Mode mode = BITMAP);
+
+private:
+	static constexpr std::uint32_t formatVersion = 1;
+
+	// creating a face per thread isn't free, threads get at least this
+	// many glyphs
+	static constexpr unsigned int minGlyphsPerThread = 16;
+
+	static unsigned int workerCount(unsigned int threadCount);
+};
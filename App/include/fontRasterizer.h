@@ -0,0 +1,41 @@
+#pragma once
+#include <optional>
+
+#include "fontData.h"
+#include "fileView.h"
+
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+// FreeType face at a fixed pixel size that rasterizes single glyphs on
+// demand; the font is read directly from the view, which has to outlive
+// the rasterizer
+//
+// a rasterizer is not thread-safe, every thread needs its own
+class FontRasterizer
+{
+public:
+	// width is automatically calculated based on height when set to 0
+	FontRasterizer(const FileView& font, unsigned int width, unsigned int height, FontData::Mode mode = FontData::BITMAP);
+
+	FontRasterizer(const FontRasterizer& other) = delete;
+	FontRasterizer(FontRasterizer&& other) noexcept;
+	~FontRasterizer();
+
+	FontRasterizer& operator=(const FontRasterizer& other) = delete;
+	FontRasterizer& operator=(FontRasterizer&& other) noexcept;
+
+	bool hasGlyph(char32_t codepoint) const;
+
+	// nullopt if the font has no glyph for this codepoint, throws if
+	// rasterizing an existing glyph fails
+	std::optional<FontData::Glyph> rasterize(char32_t codepoint);
+
+private:
+	FT_LibraryRec_* library;
+	FT_FaceRec_* face;
+	FontData::Mode mode;
+
+	void release();
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+
+// bump allocator for data that only lives for a frame (text quads, culling
+// results, ...), usually through the std::pmr containers below constructed
+// with resource()
+//
+// every thread allocates from its own pair of buffers without locking: the
+// buffer of the current frame is bumped, the one of the previous frame is
+// kept, so memory from the arena stays valid until the end of the next
+// frame; a buffer is reset when its thread first allocates in a new frame
+//
+// deallocating does nothing; both buffers of a thread start with a block
+// of initialSize, a buffer that overflows grows by another block from the
+// heap, the blocks are merged when it is reset, so frames of the same size
+// don't touch the heap once the buffers have grown
+class FrameArena
+{
+public:
+	template<class T>
+	using Vector = std::pmr::vector<T>;
+	using String = std::pmr::string;
+
+	static std::pmr::memory_resource* resource();
+	static void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+	// starts a new frame on all threads, called by Window::update()
+	static void nextFrame();
+	static std::uint64_t getFrame();
+
+	// bytes the calling thread allocated in the current frame
+	static std::size_t getUsed();
+
+private:
+	static constexpr std::size_t initialSize = 64 * 1024;
+	static constexpr std::size_t maxBlocks = 16;
+
+	class Buffer : public std::pmr::memory_resource
+	{
+	public:
+		Buffer();
+
+		void reset();
+		std::size_t getUsed() const;
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> data;
+			std::size_t size;
+		};
+
+		std::vector<Block> blocks;
+		std::size_t current = 0;
+		std::size_t offset = 0;
+		std::size_t used = 0;
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+	};
+
+	struct ThreadArena
+	{
+		Buffer buffers[2];
+		std::uint64_t frame = 0;
+	};
+
+	static std::atomic<std::uint64_t> frame;
+
+	static Buffer& getBuffer();
+};
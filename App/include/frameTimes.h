@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <filesystem>
+
+
+// wall clock frame times of a run and their percentiles, which is what
+// benchmark runs report and compare between builds
+class FrameTimes
+{
+public:
+	// times in milliseconds
+	struct Summary
+	{
+		std::size_t frames;
+		double seconds;
+		double min;
+		double avg;
+		double p50;
+		double p90;
+		double p99;
+		double max;
+	};
+
+	void add(double milliseconds);
+	bool empty() const;
+
+	Summary summarize() const;
+
+	// one "Info: <name>: ..." line
+	void print(std::ostream& stream, const std::string& name) const;
+
+	// the summary as a JSON object, returns false if the file couldn't be
+	// written
+	bool writeJson(const std::filesystem::path& path, const std::string& name) const;
+
+private:
+	std::vector<double> times;
+};
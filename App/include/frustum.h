@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <glm/glm.hpp>
+
+
+// axis aligned bounding box, empty when min > max
+struct AABB
+{
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	bool empty() const;
+	void extend(const glm::vec3& point);
+	void extend(const AABB& other);
+
+	// box around the transformed box
+	AABB transform(const glm::mat4& matrix) const;
+};
+
+// the six planes of a view frustum, extracted from a (projection * view)
+// matrix; boxes are tested conservatively, a box that is outside but close
+// to a corner of the frustum may be reported as visible
+class Frustum
+{
+public:
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	bool intersects(const AABB& box) const;
+
+	// appends the indices of the visible boxes, returns how many there are;
+	// large sets are culled in parallel when the job system is running
+	std::size_t cull(const std::vector<AABB>& boxes, std::vector<std::uint32_t>& visible) const;
+	std::size_t cull(const std::pmr::vector<AABB>& boxes, std::pmr::vector<std::uint32_t>& visible) const;
+
+private:
+	// normal (pointing inside) in xyz, distance in w
+	std::array<glm::vec4, 6> planes;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <GL/glew.h>
+
+
+// hands out names of buffers, textures and vertex arrays, which are
+// generated batchSize at a time instead of one by one
+//
+// released objects are only deleted (or recycled) once the GPU finished
+// the commands issued before their release: the releases of a frame are
+// fenced by collect() and processed when their fence signaled, so neither
+// deleting nor reusing an object waits for the GPU
+//
+// buffers and vertex arrays are recycled: a buffer's storage is freed, a
+// vertex array's attributes are disabled and its index buffer unbound, so
+// a recycled name is as good as a new one, except that buffers have to be
+// specified with glBufferData() (not glBufferStorage(), immutable storage
+// can't be freed); textures are deleted, a name may only ever be bound to
+// one target
+//
+// only the thread owning the OpenGL context may use the pool
+class GLHandlePool
+{
+public:
+	enum Type
+	{
+		BUFFER,
+		TEXTURE,
+		VERTEX_ARRAY,
+		TYPE_COUNT
+	};
+
+	struct Statistics
+	{
+		std::uint64_t generated;	// names generated by the driver
+		std::uint64_t batches;		// glGen* calls
+		std::uint64_t recycled;		// released names put back for reuse
+		std::uint64_t deleted;
+	};
+
+	static GLuint acquire(Type type);
+	static void acquire(Type type, GLsizei count, GLuint* handles);
+
+	// 0 is ignored
+	static void release(Type type, GLuint handle);
+	static void release(Type type, GLsizei count, const GLuint* handles);
+
+	// fences the releases since the last call and processes the ones whose
+	// fence signaled; called once per frame by Window::update()
+	static void collect();
+
+	// deletes all pooled and released names without waiting, has to be
+	// called before the context is destroyed
+	static void clear();
+
+	static Statistics getStatistics(Type type);
+	static void printStatistics(std::ostream& stream);
+
+private:
+	static constexpr GLsizei batchSize = 64;
+
+	// free names beyond this are deleted
+	static constexpr std::size_t maxFree = 256;
+
+	struct Released
+	{
+		GLsync fence;
+		std::vector<GLuint> handles[TYPE_COUNT];
+	};
+
+	static std::vector<GLuint> freeHandles[TYPE_COUNT];
+	static std::vector<GLuint> releasedHandles[TYPE_COUNT];
+	static std::deque<Released> fenced;
+	static Statistics statistics[TYPE_COUNT];
+
+	static void generate(Type type);
+	static void recycle(Type type, std::vector<GLuint>& handles);
+	static void deleteHandles(Type type, GLsizei count, const GLuint* handles);
+};
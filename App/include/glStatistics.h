@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <filesystem>
+
+
+// counts OpenGL calls per frame by replacing GLEW's function pointers with
+// counting wrappers; nothing is counted (or slowed down) unless installed
+//
+// entry points of OpenGL 1.1 are exported by the system's GL library and
+// not dispatched through GLEW, so they can't be wrapped; the few the engine
+// uses in drawing code (glDrawElements, glBindTexture, glTexImage2D) are
+// counted where they are called instead
+//
+// only the thread owning the OpenGL context may make counted calls
+class GLStatistics
+{
+public:
+	enum Counter
+	{
+		DRAW_CALLS,
+		STATE_CHANGES,		// bound buffers, vertex arrays, programs, textures
+		BUFFER_UPLOADS,
+		BUFFER_BYTES,
+		TEXTURE_UPLOADS,
+		TEXTURE_BYTES,
+		UNIFORM_UPDATES,
+		UNIFORM_LOCATIONS,	// glGetUniformLocation() calls
+		COUNTER_COUNT
+	};
+
+	using Counters = std::array<std::uint64_t, COUNTER_COUNT>;
+
+	// has to be called after glewInit()
+	static void install();
+	static void uninstall();
+	static bool isInstalled();
+
+	static void count(Counter counter, std::uint64_t amount = 1);
+
+	// latches the counters of the frame that ended and resets them; has to be
+	// called once per frame
+	static void endFrame();
+	static const Counters& getLastFrame();
+
+	// snake case, as used in the dump
+	static const char* toString(Counter counter);
+
+	// counters of the last historySize frames as JSON
+	static void writeJson(std::ostream& stream);
+	static bool dump(const std::filesystem::path& path);
+
+	// bytes of a pixel of an uncompressed format/type combination
+	static std::uint64_t pixelSize(unsigned int format, unsigned int type);
+
+private:
+	static constexpr std::size_t historySize = 240;
+
+	static bool installed;
+	static Counters counters;
+	static Counters lastFrame;
+
+	// ring of the last historySize frames
+	static std::array<Counters, historySize> history;
+	static std::uint64_t frameCount;
+};
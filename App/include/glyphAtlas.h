@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "fontData.h"
+#include "gpuMemory.h"
+
+
+// glyphs of a font packed into the pages (layers) of a single array texture
+// (one byte coverage per pixel), so any string can be drawn without
+// switching textures
+//
+// glyphs are inserted on first use; when all pages are full, the least
+// recently used page is evicted as a whole and its glyphs have to be
+// inserted again when they are used next time, so the memory used by the
+// atlas is bounded no matter how many different glyphs are drawn
+//
+// glyphs are packed into shelves: rows as high as the first glyph placed
+// in them, filled from left to right
+class GlyphAtlas
+{
+public:
+	// size, bearing and advance as in FontData::Glyph
+	// uvMin:		texture coordinates of the top left corner of the bitmap
+	// uvMax:		texture coordinates of the bottom right corner of the bitmap
+	// page:		layer of the array texture holding the bitmap
+
+	struct Glyph
+	{
+		glm::uvec2 size;
+		glm::ivec2 bearing;
+		int advance;
+		glm::vec2 uvMin;
+		glm::vec2 uvMax;
+		GLuint page;
+	};
+
+	enum State : std::uint8_t
+	{
+		UNKNOWN,	// not inserted yet or evicted
+		RESIDENT,	// in the atlas
+		MISSING		// the font has no glyph for this codepoint
+	};
+
+	GlyphAtlas();
+	GlyphAtlas(glm::uvec2 pageSize, GLsizei pageCount);
+
+	// the printable ASCII glyphs of font are packed right away and uploaded
+	// together with the texture
+	GlyphAtlas(glm::uvec2 pageSize, GLsizei pageCount, const FontData& font);
+
+	GlyphAtlas(const GlyphAtlas& other) = delete;
+	GlyphAtlas(GlyphAtlas&& other) noexcept;
+	~GlyphAtlas();
+
+	GlyphAtlas& operator=(const GlyphAtlas& other) = delete;
+	GlyphAtlas& operator=(GlyphAtlas&& other) noexcept;
+
+	// state of the glyph for this codepoint; a resident glyph is marked as
+	// used, which keeps its page from being evicted for longer
+	State lookup(char32_t codepoint, const Glyph*& glyph);
+
+	// nullptr if no page has space left, evictPage() makes space
+	const Glyph* insert(char32_t codepoint, const FontData::Glyph& glyph);
+	void markMissing(char32_t codepoint);
+	void evictPage();
+
+	// marks the page as used, like looking up one of its glyphs does (for
+	// glyphs that are drawn without looking them up, from a cached layout)
+	void markUsed(GLuint page);
+
+	// marks all glyphs used from now on as more recently used, once per
+	// frame
+	void nextFrame();
+
+	GLuint getTexture() const;
+	glm::uvec2 getPageSize() const;
+	GLsizei getPageCount() const;
+
+	// incremented on every eviction, glyphs looked up before a change are
+	// possibly not in the atlas anymore
+	unsigned int getEvictionCount() const;
+
+private:
+	struct Shelf
+	{
+		unsigned int y;
+		unsigned int height;
+		unsigned int width;
+	};
+
+	struct Page
+	{
+		std::vector<Shelf> shelves;
+		std::vector<char32_t> codepoints;
+		std::uint64_t lastUse;
+	};
+
+	struct Entry
+	{
+		Glyph glyph;
+		State state;
+	};
+
+	// codepoints are looked up in two levels: blocks of 256 codepoints are
+	// only allocated when a codepoint in them is used
+	static constexpr char32_t codepointCount = 0x110000;
+	static constexpr char32_t blockSize = 256;
+	using Block = std::array<Entry, blockSize>;
+
+	// free pixels around every glyph, so linear filtering doesn't pick up
+	// neighbouring glyphs
+	static constexpr unsigned int padding = 1;
+
+	GLuint texture;
+	glm::uvec2 pageSize;
+	GPUMemory::Allocation gpuMemory;
+
+	std::vector<Page> pages;
+	std::vector<std::unique_ptr<Block>> blocks;
+
+	std::uint64_t frame;
+	unsigned int evictionCount;
+
+	Entry& getEntry(char32_t codepoint);
+
+	// packs the glyph into a page without uploading it, nullptr if no page
+	// has space left
+	const Glyph* place(char32_t codepoint, const FontData::Glyph& glyph, glm::uvec2& position);
+
+	static bool pack(
+		std::vector<Shelf>& shelves,
+		glm::uvec2 pageSize,
+		glm::uvec2 glyphSize,
+		glm::uvec2& position
+	);
+
+	void deleteGLObjects();
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+
+// accounts for the video memory the engine allocates (buffers, textures,
+// render targets) by category and compares it against a budget, which
+// asset systems query before loading (e.g. which mip levels of a texture
+// to upload) or to decide what to evict
+//
+// the accounting is what the engine asked for, not what the driver
+// allocated (alignment, padding, driver-side copies aren't known); what
+// the device reports is read from GL_NVX_gpu_memory_info or GL_ATI_meminfo
+// where available
+class GPUMemory
+{
+public:
+	enum Category
+	{
+		GEOMETRY,
+		TEXTURES,
+		GLYPHS,			// glyph atlases and text buffers
+		RENDER_TARGETS,
+		CATEGORY_COUNT
+	};
+
+	// accounted memory of one object, released with it
+	class Allocation
+	{
+	public:
+		Allocation();
+		Allocation(Category category, std::uint64_t size);
+
+		Allocation(const Allocation& other) = delete;
+		Allocation(Allocation&& other) noexcept;
+		~Allocation();
+
+		Allocation& operator=(const Allocation& other) = delete;
+		Allocation& operator=(Allocation&& other) noexcept;
+
+		// for objects whose storage grows or shrinks
+		void resize(std::uint64_t size);
+		std::uint64_t getSize() const;
+
+	private:
+		Category category;
+		std::uint64_t size;
+	};
+
+	// sizes are in bytes, 0 when the device doesn't report them
+	struct DeviceInfo
+	{
+		bool available;
+		std::uint64_t dedicated;	// NVX only
+		std::uint64_t free;
+		std::uint64_t evicted;		// NVX only, since the context was created
+	};
+
+	static std::uint64_t getUsage(Category category);
+	static std::uint64_t getUsage();
+
+	// queries the driver, needs the OpenGL context
+	static DeviceInfo queryDevice();
+
+	// 0 (the default) derives the budget from the device: a share of its
+	// dedicated memory, or of the memory in use and still free; without
+	// device information the budget is unlimited
+	static void setBudget(std::uint64_t budget);
+	static std::uint64_t getBudget();
+
+	// budget minus usage, negative when over budget
+	static std::int64_t getHeadroom();
+	static bool fits(std::uint64_t size);
+
+	static const char* toString(Category category);
+	static void printStatistics(std::ostream& stream);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	// share of the device memory the derived budget allows
+	static constexpr double deviceShare = 0.8;
+
+	// the derived budget is refreshed at most this often (seconds)
+	static constexpr double refreshInterval = 1.0;
+
+	static std::atomic<std::uint64_t> usage[CATEGORY_COUNT];
+
+	static std::uint64_t budget;
+	static std::uint64_t derivedBudget;
+	static Clock::time_point derivedTime;
+	static bool derived;
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <xxhash.h>
+
+
+// 64 bit xxHash (XXH3), used for content hashes and lookup keys
+inline std::uint64_t hash64(const void* data, std::size_t size, std::uint64_t seed = 0)
+{
+	return XXH3_64bits_withSeed(data, size, seed);
+}
+
+inline std::uint64_t hash64(std::string_view str, std::uint64_t seed = 0)
+{
+	return XXH3_64bits_withSeed(str.data(), str.size(), seed);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+
+
+// input events (keys, cursor, scroll) and frame delta times of a run, as
+// recorded by a Window; replaying them in another Window reproduces the
+// run frame by frame
+//
+// files are zstd compressed, a minute of flying takes a few kilobytes
+class InputRecording
+{
+public:
+	enum EventType : std::uint8_t
+	{
+		KEY,
+		CURSOR_POS,
+		SCROLL
+	};
+
+	// keys store the key in x and the action in y
+	struct Event
+	{
+		std::uint32_t frame;
+		EventType type;
+		double x;
+		double y;
+	};
+
+	// one per frame, in seconds
+	std::vector<double> deltaTimes;
+
+	// in the order they were received, events of a frame are received after
+	// its delta time is known
+	std::vector<Event> events;
+
+	std::size_t getFrameCount() const;
+
+	// throws std::runtime_error if the file can't be read or written
+	static InputRecording load(const std::filesystem::path& path);
+	void save(const std::filesystem::path& path) const;
+
+private:
+	static constexpr std::uint32_t magic = 0x52504E49;	// "INPR"
+	static constexpr std::uint32_t formatVersion = 1;
+
+	std::vector<std::byte> serialize() const;
+	static InputRecording deserialize(const std::byte* data, std::size_t size);
+};
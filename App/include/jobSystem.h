@@ -0,0 +1,211 @@
+#pragma once
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+
+// work-stealing job scheduler: every worker thread, and the thread that
+// started the system, owns a Chase-Lev deque it pushes to and pops from at
+// the bottom, idle threads steal from the top of the others; threads that
+// aren't part of the system push to a shared queue instead
+//
+// jobs are grouped by counters, wait() runs queued jobs until the counter
+// reaches zero, so the waiting thread (and a job waiting for nested jobs)
+// works instead of blocking; a job can depend on a counter and is only
+// queued once that counter reached zero
+//
+// jobs of the started threads come from a fixed pool of each thread and
+// don't allocate (except for what std::function captures in run()), they
+// are allocated when the pool runs out; when a deque is full, the job runs
+// right away instead
+//
+// while the system isn't started, run() and parallelFor() run the jobs on
+// the calling thread
+class JobSystem
+{
+private:
+	struct Job;
+
+public:
+	// jobs still to finish, the first exception one of them threw is
+	// rethrown by wait(); a counter that jobs were counted by has to be
+	// waited for before it is destroyed
+	class Counter
+	{
+	public:
+		Counter();
+
+		Counter(const Counter& other) = delete;
+		Counter& operator=(const Counter& other) = delete;
+
+		bool done() const;
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<std::uint32_t> count;
+
+		std::mutex mutex;
+		std::exception_ptr error;
+
+		// jobs depending on the counter
+		std::vector<Job*> continuations;
+	};
+
+	// workerCount 0 starts a worker for every hardware thread but the
+	// calling one, which takes part while it waits
+	static void start(unsigned int workerCount = 0);
+	// finishes the queued jobs first, only the thread that started the
+	// system may stop it and no other thread may submit jobs meanwhile
+	static void stop();
+
+	static bool isRunning();
+	// workers plus the thread that started the system, 1 when not running
+	static unsigned int getThreadCount();
+
+	// counter and dependency are optional, the job is counted by counter
+	// and only runs after dependency reached zero
+	static void run(std::function<void()> function, Counter* counter = nullptr, Counter* dependency = nullptr);
+
+	// runs queued jobs while the counter isn't zero
+	static void wait(Counter& counter);
+
+	// calls function(first, last) for the ranges [k * grainSize, (k + 1) *
+	// grainSize) of [0, count) in parallel, the first range on the calling
+	// thread, and returns when all are done
+	template<class Function>
+	static void parallelFor(std::size_t count, std::size_t grainSize, const Function& function);
+
+private:
+	using RangeFunction = void (*)(const void* function, std::size_t first, std::size_t last);
+
+	struct Job
+	{
+		std::function<void()> function;
+
+		// parallelFor() jobs, without std::function
+		RangeFunction range;
+		const void* rangeFunction;
+		std::size_t first;
+		std::size_t last;
+
+		Counter* counter;
+
+		// pooled jobs are in use until they finished, others are deleted
+		bool pooled;
+		std::atomic<bool> busy;
+	};
+
+	// Chase-Lev deque with a fixed capacity (Lê, Pop, Cohen, Zappa Nardelli:
+	// "Correct and Efficient Work-Stealing for Weak Memory Models")
+	class Deque
+	{
+	public:
+		Deque();
+
+		// owner only
+		bool push(Job* job);
+		Job* pop();
+
+		// any thread
+		Job* steal();
+
+	private:
+		static constexpr std::int64_t capacity = 4096;
+
+		alignas(64) std::atomic<std::int64_t> top;
+		alignas(64) std::atomic<std::int64_t> bottom;
+		std::unique_ptr<std::atomic<Job*>[]> buffer;
+	};
+
+	struct Worker
+	{
+		Deque deque;
+		std::unique_ptr<Job[]> jobs;
+		std::size_t nextJob = 0;
+		std::thread thread;
+	};
+
+	static constexpr std::size_t jobPoolSize = 4096;
+
+	// index of the calling thread's worker, -1 for other threads
+	static thread_local int workerIndex;
+
+	// worker 0 is the thread that started the system
+	static std::vector<std::unique_ptr<Worker>> workers;
+	static std::atomic<bool> running;
+	static std::atomic<bool> stopping;
+
+	static std::mutex queueMutex;
+	static std::deque<Job*> queue;
+
+	// queued jobs and sleeping workers, workers sleep while there are none
+	static std::atomic<std::int64_t> queued;
+	static std::atomic<unsigned int> sleeping;
+	static std::mutex sleepMutex;
+	static std::condition_variable wakeUp;
+
+	static Job* allocate();
+	static void submit(Job* job, Counter* dependency);
+	static void push(Job* job);
+	static Job* take();
+	static void execute(Job* job);
+	static void finish(Counter* counter, std::exception_ptr error);
+
+	static void runRange(RangeFunction range, const void* function,
+		std::size_t first, std::size_t last, Counter& counter
+	);
+
+	static void workerMain(int index);
+};
+
+template<class Function>
+void JobSystem::parallelFor(std::size_t count, std::size_t grainSize, const Function& function)
+{
+	if (count == 0)
+		return;
+
+	if (grainSize == 0)
+		grainSize = 1;
+
+	if (count <= grainSize || !isRunning())
+	{
+		function(std::size_t(0), count);
+		return;
+	}
+
+	RangeFunction range = [](const void* function, std::size_t first, std::size_t last)
+	{
+		(*static_cast<const Function*>(function))(first, last);
+	};
+
+	Counter counter;
+
+	for (std::size_t first = grainSize; first < count; first += grainSize)
+		runRange(range, &function, first, std::min(first + grainSize, count), counter);
+
+	// the queued ranges refer to function, they have to be done before
+	// an exception leaves this scope
+	std::exception_ptr error;
+	try { function(std::size_t(0), grainSize); }
+	catch (...) { error = std::current_exception(); }
+
+	try { wait(counter); }
+	catch (...)
+	{
+		if (!error)
+			throw;
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
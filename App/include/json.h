@@ -0,0 +1,19 @@
+#pragma once
+#include <ostream>
+#include <string_view>
+
+
+// writes str as the contents of a JSON string: quotes and backslashes are
+// escaped, control characters replaced with spaces
+inline void writeJsonEscaped(std::ostream& stream, std::string_view str)
+{
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			stream << '\\' << c;
+		else if (static_cast<unsigned char>(c) < 0x20)
+			stream << ' ';
+		else
+			stream << c;
+	}
+}
@@ -2,11 +2,14 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <filesystem>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
 #include "texture.h"
 #include "shader.h"
+#include "gpuMemory.h"
 
 
 struct Vertex
@@ -21,15 +24,31 @@ struct Vertex
 class Mesh
 {
 public:
+	// what stays in system memory once the buffers are uploaded
+	enum Retention
+	{
+		KEEP,
+		DROP,
+		POSITIONS_ONLY	// positions and indices, for picking and culling
+	};
+
+	// source and sourceIndex (the model file and the index of the mesh in
+	// it) are where dropped data is read again from, when asked for
 	Mesh(
 		const std::vector<Vertex>& vertices,
 		const std::vector<GLuint>& indices,
-		const std::vector<std::shared_ptr<Texture>>& textures
+		const std::vector<std::shared_ptr<Texture>>& textures,
+		Retention retention = KEEP,
+		const std::filesystem::path& source = {},
+		std::size_t sourceIndex = 0
 	);
 	Mesh(
 		std::vector<Vertex>&& vertices,
 		std::vector<GLuint>&& indices,
-		std::vector<std::shared_ptr<Texture>>&& textures
+		std::vector<std::shared_ptr<Texture>>&& textures,
+		Retention retention = KEEP,
+		const std::filesystem::path& source = {},
+		std::size_t sourceIndex = 0
 	);
 	Mesh(const Mesh& other) = delete;
 	Mesh(Mesh&& other) noexcept;
@@ -38,20 +57,62 @@ public:
 	Mesh& operator=(const Mesh& other) = delete;
 	Mesh& operator=(Mesh&& other) noexcept;
 
+	// dropped vertices and indices are read again from the source model
+	// (usually the cooked one) on first use and kept from then on, so this
+	// is slow once and for rare consumers only
 	const std::vector<Vertex>& getVertices() const;
 	const std::vector<GLuint>& getIndices() const;
+	// built from the vertices on first use, unless retained
+	const std::vector<glm::vec3>& getPositions() const;
 	const std::vector<std::shared_ptr<Texture>>& getTextures() const;
 
+	Retention getRetention() const;
+	// keeps at least what retention keeps from now on, dropped data is read
+	// again from the source; a shared mesh serves the user asking for the
+	// most, it never drops data another user asked for
+	void retain(Retention retention);
+
+	// size of the vertex and index buffers plus the retained copies
+	std::size_t getMemorySize() const;
+	// size of the copies kept in system memory only
+	std::size_t getRetainedSize() const;
+
 	
 	void draw(Shader& shader);
 
 private:
-	std::vector<Vertex> vertices;
-	std::vector<GLuint> indices;
+	// filled again by the getters, guarded by mutex
+	mutable std::vector<Vertex> vertices;
+	mutable std::vector<GLuint> indices;
+	mutable std::vector<glm::vec3> positions;
 	std::vector<std::shared_ptr<Texture>> textures;
 
+	// uniform names of the textures, built once, and their locations in
+	// the program they were last looked up in
+	std::vector<std::string> samplerNames;
+	std::vector<GLint> samplerLocations;
+	GLuint samplerProgram;
+
+	Retention retention;
+	std::filesystem::path source;
+	std::size_t sourceIndex;
+	mutable std::mutex mutex;
+
+	// the buffers' sizes, the vectors may be gone
+	GLsizei vertexCount;
+	GLsizei indexCount;
+
 	GLuint VAO, VBO, EBO;
+	GPUMemory::Allocation gpuMemory;
 
 	void setupGLObjects();
 	void deleteGLObjects();
+	void setupSamplerNames();
+
+	std::size_t getBufferSize() const;
+
+	// drops what the retention policy doesn't keep
+	void applyRetention();
+	// needs the mutex
+	void reload() const;
 };
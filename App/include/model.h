@@ -1,21 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <vector>
 #include <string>
 #include <memory>
-#include <unordered_map>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
 #include <glm/glm.hpp>
 
 #include "shader.h"
 #include "mesh.h"
+#include "frustum.h"
 
 
 class Model
 {
 public:
-	Model(const std::filesystem::path& path);
+	// meshes and textures are shared with other models through the asset
+	// registry; load() shares the whole model as well
+	//
+	// retention is what the meshes keep in system memory after the upload;
+	// it isn't part of the registry key: a shared model or mesh that keeps
+	// less than retention is upgraded (its dropped data is read again), so
+	// it keeps what the user asking for the most asked for
+	Model(const std::filesystem::path& path, Mesh::Retention retention = Mesh::KEEP);
+
+	static std::shared_ptr<Model> load(
+		const std::filesystem::path& path,
+		Mesh::Retention retention = Mesh::KEEP
+	);
 
 	void draw(
 		Shader& shader,
@@ -25,22 +37,25 @@ public:
 		GLfloat angle = 0.0f
 	);
 
-private:
-	std::vector<Mesh> meshes;
-	std::unordered_map<
-		std::filesystem::path,
-		std::shared_ptr<Texture>
-	> loadedTextures;
+	// transformation draw() applies
+	static glm::mat4 getModelMatrix(
+		glm::vec3 pos = glm::vec3(0.0f, 0.0f, 0.0f),
+		GLfloat scale = 1.0f,
+		glm::vec3 axis = glm::vec3(0.0f, 1.0f, 0.0f),
+		GLfloat angle = 0.0f
+	);
 
-	std::filesystem::path baseDir;
+	// bounds of all meshes in model space
+	const AABB& getBounds() const;
 
-	void processNode(aiNode* node, const aiScene* scene);
-	void processMesh(aiMesh* mesh, const aiScene* scene);
+	const std::vector<std::shared_ptr<Mesh>>& getMeshes() const;
 
-	void getVertices(std::vector<Vertex>& vertices, aiMesh* mesh);
-	void getIndices(std::vector<GLuint>& indices, aiMesh* mesh);
-	void getTextures(std::vector<std::shared_ptr<Texture>>& textures,
-		aiMesh* mesh, const aiScene* scene
-	);
+	// size of all meshes and textures, including the shared ones
+	std::size_t getMemorySize() const;
+
+private:
+	std::vector<std::shared_ptr<Mesh>> meshes;
+	AABB bounds;
 
+	Model(const std::filesystem::path& path, std::uint64_t contentHash, Mesh::Retention retention);
 };
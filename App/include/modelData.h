@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <GL/glew.h>
+#include <assimp/scene.h>
+
+#include "fileView.h"
+#include "mesh.h"
+
+
+// CPU side result of importing a model file, independent of any OpenGL
+// context; this is what the cooker stores and what Model uploads
+class ModelData
+{
+public:
+	struct TextureRef
+	{
+		std::string path;
+		std::string name;
+	};
+
+	struct MeshData
+	{
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+		std::vector<TextureRef> textures;
+	};
+
+	// files read by the importer besides the model file itself (.mtl
+	// files for example) with the hash of their content at import time
+	struct Dependency
+	{
+		std::string path;
+		std::uint64_t hash;
+	};
+
+	std::vector<MeshData> meshes;
+	std::vector<Dependency> dependencies;
+
+	// loads the cooked model if an up to date one exists, imports (and
+	// caches) it otherwise
+	static ModelData load(const std::filesystem::path& path);
+	static ModelData import(const std::filesystem::path& path);
+
+	std::vector<std::byte> serialize() const;
+	static ModelData deserialize(const FileView& data);
+	// empty instead of throwing when the data is corrupt
+	static std::optional<ModelData> tryDeserialize(const FileView& data);
+
+	// true if all dependencies still have the content they were imported with
+	bool isUpToDate() const;
+
+	// identifies import settings and format version, part of the cooked key
+	static std::string params();
+
+private:
+	static constexpr std::uint32_t formatVersion = 1;
+
+	void processNode(aiNode* node, const aiScene* scene, const std::filesystem::path& baseDir);
+	void processMesh(aiMesh* mesh, const aiScene* scene, const std::filesystem::path& baseDir);
+
+	static void getVertices(std::vector<Vertex>& vertices, aiMesh* mesh);
+	static void getIndices(std::vector<GLuint>& indices, aiMesh* mesh);
+	static void getTextures(std::vector<TextureRef>& textures,
+		aiMesh* mesh, const aiScene* scene, const std::filesystem::path& baseDir
+	);
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <unordered_map>
+#include <GL/glew.h>
+
+
+class TextRenderer;
+class Shader;
+
+// frame profiler for the thread owning the OpenGL context: measures CPU and
+// GPU time of nested scopes and keeps the last historySize frames of every
+// scope for statistics
+//
+// GPU times are measured with timestamp queries (elapsed time queries can't
+// be nested) and read back frameLatency frames later, when the GPU is done
+// with them, so reading the results never stalls; results that still aren't
+// available then are dropped
+//
+// the whole frame, from one endFrame() to the next, is the root scope
+class Profiler
+{
+public:
+	// times in milliseconds
+	struct Timing
+	{
+		double min;
+		double max;
+		double p50;
+		double p99;
+	};
+
+	struct Statistics
+	{
+		std::string name;
+		int depth;
+		std::size_t cpuSamples;
+		std::size_t gpuSamples;
+		Timing cpu;
+		Timing gpu;
+	};
+
+	// measures the time from construction to destruction
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name);
+		~Scope();
+
+		Scope(const Scope& other) = delete;
+		Scope& operator=(const Scope& other) = delete;
+
+	private:
+		bool active;
+	};
+
+	// disabled by default, a disabled profiler costs a branch per scope
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+
+	static void beginScope(const char* name);
+	static void endScope();
+
+	// ends the current frame (including all scopes still open) and begins
+	// the next one; has to be called once per frame before swapping buffers
+	static void endFrame();
+
+	// scopes in the order they were first used
+	static std::vector<Statistics> getStatistics();
+	static void printStatistics(std::ostream& stream);
+
+	// one line per scope, drawn from (x, y) measured from the top left
+	// window corner downwards
+	static void renderOverlay(TextRenderer& textRenderer, Shader& shader, float x, float y);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr std::size_t frameLatency = 4;
+	static constexpr std::size_t historySize = 240;
+
+	struct Record
+	{
+		std::uint32_t scope;
+		Clock::time_point begin;
+		Clock::time_point end;
+		GLuint beginQuery;
+		GLuint endQuery;
+	};
+
+	// queries are reused by every frame issued in the same slot
+	struct Frame
+	{
+		std::vector<Record> records;
+		std::vector<GLuint> queries;
+		std::size_t queryCount = 0;
+	};
+
+	// samples are kept in a ring of historySize entries
+	struct History
+	{
+		std::string name;
+		int depth;
+		std::vector<float> cpu;
+		std::vector<float> gpu;
+		std::size_t cpuNext = 0;
+		std::size_t gpuNext = 0;
+	};
+
+	static bool enabled;
+	static bool frameOpen;
+	static bool timerQueries;
+
+	static Frame frames[frameLatency];
+	static std::size_t frame;
+
+	// indices of the open records of the current frame
+	static std::vector<std::size_t> stack;
+
+	// scopes are identified by their path ("frame/draw/text"), so a name
+	// used below different parents is measured separately
+	static std::vector<History> scopes;
+	static std::unordered_map<std::string, std::uint32_t> scopeIndices;
+	static std::string path;
+
+	static void beginFrame();
+	static void readBack(Frame& frame);
+	static GLuint timestamp(Frame& frame);
+
+	static void addSample(std::vector<float>& samples, std::size_t& next, float sample);
+	static Timing getTiming(const std::vector<float>& samples);
+};
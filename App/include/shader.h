@@ -1,8 +1,14 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <filesystem>
+#include <initializer_list>
 #include <GL/glew.h>
 
+#include "fileView.h"
+
 
 class Shader
 {
@@ -46,51 +52,83 @@ public:
 
 	void useProgram();
 
-	void setUniform1f(const std::string& uniformName, GLfloat v0);
-	void setUniform2f(const std::string& uniformName, GLfloat v0, GLfloat v1);
-	void setUniform3f(const std::string& uniformName, GLfloat v0, GLfloat v1, GLfloat v2);
-	void setUniform4f(const std::string& uniformName, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
-
-	void setUniform1i(const std::string& uniformName, GLint v0);
-	void setUniform2i(const std::string& uniformName, GLint v0, GLint v1);
-	void setUniform3i(const std::string& uniformName, GLint v0, GLint v1, GLint v2);
-	void setUniform4i(const std::string& uniformName, GLint v0, GLint v1, GLint v2, GLint v3);
-
-	void setUniform1ui(const std::string& uniformName, GLuint v0);
-	void setUniform2ui(const std::string& uniformName, GLuint v0, GLuint v1);
-	void setUniform3ui(const std::string& uniformName, GLuint v0, GLuint v1, GLuint v2);
-	void setUniform4ui(const std::string& uniformName, GLuint v0, GLuint v1, GLuint v2, GLuint v3);
-
-	void setUniform1fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1);
-	void setUniform2fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1);
-	void setUniform3fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1);
-	void setUniform4fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1);
-
-	void setUniform1iv(const std::string& uniformName, const GLint* value, GLsizei count = 1);
-	void setUniform2iv(const std::string& uniformName, const GLint* value, GLsizei count = 1);
-	void setUniform3iv(const std::string& uniformName, const GLint* value, GLsizei count = 1);
-	void setUniform4iv(const std::string& uniformName, const GLint* value, GLsizei count = 1);
-
-	void setUniform1uiv(const std::string& uniformName, const GLuint* value, GLsizei count = 1);
-	void setUniform2uiv(const std::string& uniformName, const GLuint* value, GLsizei count = 1);
-	void setUniform3uiv(const std::string& uniformName, const GLuint* value, GLsizei count = 1);
-	void setUniform4uiv(const std::string& uniformName, const GLuint* value, GLsizei count = 1);
-
-	void setUniformMatrix2fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
-	void setUniformMatrix3fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
-	void setUniformMatrix4fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
-
-	void setUniformMatrix2x3fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
-	void setUniformMatrix3x2fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
-	void setUniformMatrix2x4fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
-	void setUniformMatrix4x2fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
-	void setUniformMatrix3x4fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
-	void setUniformMatrix4x3fv(const std::string& uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+	void setUniform1f(std::string_view uniformName, GLfloat v0);
+	void setUniform2f(std::string_view uniformName, GLfloat v0, GLfloat v1);
+	void setUniform3f(std::string_view uniformName, GLfloat v0, GLfloat v1, GLfloat v2);
+	void setUniform4f(std::string_view uniformName, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+
+	void setUniform1i(std::string_view uniformName, GLint v0);
+	void setUniform2i(std::string_view uniformName, GLint v0, GLint v1);
+	void setUniform3i(std::string_view uniformName, GLint v0, GLint v1, GLint v2);
+	void setUniform4i(std::string_view uniformName, GLint v0, GLint v1, GLint v2, GLint v3);
+
+	void setUniform1ui(std::string_view uniformName, GLuint v0);
+	void setUniform2ui(std::string_view uniformName, GLuint v0, GLuint v1);
+	void setUniform3ui(std::string_view uniformName, GLuint v0, GLuint v1, GLuint v2);
+	void setUniform4ui(std::string_view uniformName, GLuint v0, GLuint v1, GLuint v2, GLuint v3);
+
+	void setUniform1fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1);
+	void setUniform2fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1);
+	void setUniform3fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1);
+	void setUniform4fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1);
+
+	void setUniform1iv(std::string_view uniformName, const GLint* value, GLsizei count = 1);
+	void setUniform2iv(std::string_view uniformName, const GLint* value, GLsizei count = 1);
+	void setUniform3iv(std::string_view uniformName, const GLint* value, GLsizei count = 1);
+	void setUniform4iv(std::string_view uniformName, const GLint* value, GLsizei count = 1);
+
+	void setUniform1uiv(std::string_view uniformName, const GLuint* value, GLsizei count = 1);
+	void setUniform2uiv(std::string_view uniformName, const GLuint* value, GLsizei count = 1);
+	void setUniform3uiv(std::string_view uniformName, const GLuint* value, GLsizei count = 1);
+	void setUniform4uiv(std::string_view uniformName, const GLuint* value, GLsizei count = 1);
+
+	void setUniformMatrix2fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+	void setUniformMatrix3fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+	void setUniformMatrix4fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+
+	void setUniformMatrix2x3fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+	void setUniformMatrix3x2fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+	void setUniformMatrix2x4fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+	void setUniformMatrix4x2fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+	void setUniformMatrix3x4fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+	void setUniformMatrix4x3fv(std::string_view uniformName, const GLfloat* value, GLsizei count = 1, bool transpose = false);
+
+	// locations of the active uniforms are looked up once, when the program
+	// is linked, other names when they are first used
+	GLint getUniformLocation(std::string_view uniformName);
+	// same, but names that aren't cached are looked up without caching them,
+	// so it never allocates (for callers that cache the location themselves)
+	GLint findUniformLocation(std::string_view uniformName) const;
+
+	GLuint getProgram() const;
 
 private:
+	struct Stage
+	{
+		std::filesystem::path path;
+		GLenum type;
+	};
+
+	// hashes strings and string views alike, so looking up a name doesn't
+	// construct a string
+	struct NameHash
+	{
+		using is_transparent = void;
+		std::size_t operator()(std::string_view name) const;
+	};
+
 	GLuint program;
+	std::unordered_map<std::string, GLint, NameHash, std::equal_to<>> uniformLocations;
+
+	// linked programs are cached as program binaries, if supported
+	void createProgram(std::initializer_list<Stage> stages);
+	static bool programBinarySupported();
+	static std::string programBinaryParams();
+	bool loadProgramBinary(std::uint64_t key);
+	void storeProgramBinary(std::uint64_t key);
 
-	void compileShader(const std::filesystem::path& shaderPath, GLenum shaderType);
+	void compileShader(const FileView& shaderFile, GLenum shaderType);
 	void linkProgram();
+	void cacheUniformLocations();
 	void deleteProgram();
 };
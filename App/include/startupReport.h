@@ -0,0 +1,109 @@
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <string_view>
+#include <filesystem>
+
+
+// where the time before the first frame goes: startup phases (window
+// creation, GLEW init, shader builds, ...) as a tree and every asset loaded
+// meanwhile, split into reading (I/O, including cooked data), decoding and
+// GPU upload
+//
+// recording starts with the process and ends with finish(), which is
+// called at the first frame; afterwards phases and asset scopes cost a
+// branch; asset scopes may be used from any thread
+class StartupReport
+{
+public:
+	enum Stage
+	{
+		IO,
+		DECODE,
+		UPLOAD,
+		STAGE_COUNT
+	};
+
+	// phases nest, they have to end in reverse order and on the main thread
+	static void beginPhase(const char* name);
+	static void endPhase();
+
+	class Phase
+	{
+	public:
+		explicit Phase(const char* name);
+		~Phase();
+
+		Phase(const Phase& other) = delete;
+		Phase& operator=(const Phase& other) = delete;
+	};
+
+	// adds the time from construction to destruction to a stage of the
+	// asset, identified by kind and path; next() switches to another stage
+	// on the way
+	class AssetScope
+	{
+	public:
+		AssetScope(const char* kind, const std::filesystem::path& path, Stage stage);
+		~AssetScope();
+
+		void next(Stage stage);
+
+		AssetScope(const AssetScope& other) = delete;
+		AssetScope& operator=(const AssetScope& other) = delete;
+
+	private:
+		const char* kind;
+		std::filesystem::path path;
+		Stage stage;
+		std::chrono::steady_clock::time_point begin;
+	};
+
+	// ends recording, phases still open end as well
+	static void finish();
+	static bool isFinished();
+
+	// phases in the order they began, assets by their total time
+	static void print(std::ostream& stream);
+
+	// returns false if the file couldn't be written
+	static bool writeJson(const std::filesystem::path& path);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct PhaseRecord
+	{
+		const char* name;
+		int depth;
+		Clock::time_point begin;
+		Clock::time_point end;
+	};
+
+	struct AssetRecord
+	{
+		std::string kind;
+		std::string path;
+		double seconds[STAGE_COUNT];
+
+		double total() const;
+	};
+
+	static const Clock::time_point startTime;
+	static Clock::time_point finishTime;
+	static std::atomic<bool> finished;
+
+	static std::vector<PhaseRecord> phases;
+	static std::vector<std::size_t> openPhases;
+
+	static std::mutex mutex;
+	static std::vector<AssetRecord> assets;
+
+	static void addAssetTime(const char* kind, const std::filesystem::path& path, Stage stage, double seconds);
+	static std::vector<AssetRecord> getSortedAssets();
+	static double milliseconds(Clock::time_point begin, Clock::time_point end);
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "gpuMemory.h"
+
+
+class TextRenderer;
+
+// glyph quads of a string shaped once and kept in their own vertex buffer;
+// TextRenderer::renderText() only shapes and uploads the string again when
+// the string, its position, origin, color or scale changed, so a label
+// that is unchanged costs a single draw call
+//
+// a layout is bound to the renderer (and OpenGL context) it is first used
+// with and has to outlive the next TextRenderer::flush()
+class TextLayout
+{
+public:
+	TextLayout();
+
+	TextLayout(const TextLayout& other) = delete;
+	TextLayout(TextLayout&& other) noexcept;
+	~TextLayout();
+
+	TextLayout& operator=(const TextLayout& other) = delete;
+	TextLayout& operator=(TextLayout&& other) noexcept;
+
+	// number of times the layout was shaped (and uploaded)
+	unsigned int getShapeCount() const;
+
+private:
+	friend class TextRenderer;
+
+	// the key the quads were shaped for; TOP_LEFT positions depend on the
+	// window height as well
+	const TextRenderer* renderer;
+	std::string str;
+	glm::vec2 position;
+	int origin;
+	glm::vec3 color;
+	float scale;
+	int windowHeight;
+
+	// glyphs of evicted atlas pages are at different positions when
+	// they are inserted again
+	unsigned int evictionCount;
+	// atlas pages the glyphs are on, they are marked as used whenever the
+	// layout is drawn without being shaped again
+	std::vector<GLuint> pages;
+
+	GLsizei quadCount;
+	GLsizeiptr capacity;
+	unsigned int shapeCount;
+
+	GLuint VAO, VBO;
+	GPUMemory::Allocation gpuMemory;
+
+	void deleteGLObjects();
+};
@@ -1,12 +1,18 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <filesystem>
 #include <memory>
-#include <map>
+#include <vector>
+#include <GL/glew.h>
 #include <glm/glm.hpp>
 
 #include "window.h"
 #include "shader.h"
+#include "glyphAtlas.h"
+#include "fontRasterizer.h"
+#include "fileView.h"
+#include "textLayout.h"
 
 
 class TextRenderer
@@ -19,9 +25,15 @@ public:
 	};
 
 	// width is automatically calculated based on height when set to 0
+	//
+	// in SDF mode glyphs are rasterized once as distance fields and scaled
+	// to width/height, so a single renderer (and atlas) serves every size
+	// through the scale argument of renderText(); the text has to be drawn
+	// with an SDF shader (textSdf.frag) then
 	TextRenderer(
 		const std::filesystem::path& fontPath,
-		unsigned int width, unsigned int height
+		unsigned int width, unsigned int height,
+		FontData::Mode mode = FontData::BITMAP
 	);
 
 	TextRenderer(const TextRenderer& other) = delete;
@@ -32,14 +44,36 @@ public:
 	TextRenderer& operator=(TextRenderer&& other) noexcept;
 
 	// (x, y) is the position of the bottom left pixel from the first
-	// char in str measured from the BOTTOM_LEFT/TOP_LEFT window corner
+	// char in str measured from the BOTTOM_LEFT/TOP_LEFT window corner;
+	// str is UTF-8 encoded, glyphs are rasterized on first use
+	//
+	// the quads of all strings are only batched here, they are drawn with
+	// a single draw call by flush() or endFrame(), one of which has to be
+	// called at frame end
 	void renderText(
 		Shader& shader,
-		const std::string& str,
+		std::string_view str,
 		float x, float y, Origin origin = BOTTOM_LEFT,
 		glm::vec3 color = glm::vec3(1.0f, 0.804f, 0.133f),
 		float scale = 1.0f
 	);
+
+	// same as above, but the quads are shaped into the layout and only
+	// shaped (and uploaded) again when any of the arguments changed
+	void renderText(
+		Shader& shader,
+		TextLayout& layout,
+		std::string_view str,
+		float x, float y, Origin origin = BOTTOM_LEFT,
+		glm::vec3 color = glm::vec3(1.0f, 0.804f, 0.133f),
+		float scale = 1.0f
+	);
+
+	void flush();
+	// flushes and ages the glyphs used so far, so the atlas evicts the pages
+	// of the glyphs that weren't drawn for the most frames; call it once
+	// per frame
+	void endFrame();
 	
 	unsigned int getDefaultWidth() const;
 	unsigned int getDefaultHeight() const;
@@ -53,31 +87,66 @@ public:
 	int getMaxBearingY() const;
 
 private:
-	// size.x:		width in pixels of the bitmap
-	// size.y:		height in pixels of the bitmap
-	// bearing.x:	horizontal position in pixels of the bitmap relative to the origin
-	// bearing.y:	vertical position in pixels of the bitmap relative to the baseline
-	// advance:		horizontal distance in 1/64 pixels from the origin to the origin of the next glyph
-
-	struct Char
+	struct Vertex
 	{
-		GLuint texture;
-		glm::uvec2 size;
-		glm::ivec2 bearing;
-		int advance;
+		glm::vec2 position;
+		glm::vec3 texCoords;	// z is the atlas page
+		GLuint color;			// RGBA, 8 bits per channel
 	};
 
+	// the vertex buffer is split into regions that are written and drawn
+	// in turn, so the CPU writes one region while the GPU may still read
+	// the others; a fence per region tells when the GPU is done with it
+	static constexpr GLsizei regionCount = 3;
+	static constexpr GLsizei quadsPerRegion = 16384;
+
+	// the atlas holds at most this many pages, the least recently used
+	// page is evicted when all are full
+	static constexpr unsigned int atlasPageSize = 512;
+	static constexpr GLsizei atlasPageCount = 4;
+
 	Window* window;
 
+	// glyphs are rasterized at rasterSize and scaled by glyphScale to the
+	// default size (1.0 for bitmaps)
+	FontData::Mode mode;
+	glm::uvec2 rasterSize;
+	GLfloat glyphScale;
+
 	glm::uvec2 defaultSize;
 	glm::uvec2 maxCharSize;
 	glm::uvec2 maxLetterSize;
 	glm::uvec2 maxNumberSize;
 	glm::ivec2 maxBearing;
 
-	std::map<char, Char> chars;
+	// the font stays mapped, glyphs outside ASCII are rasterized on demand;
+	// FreeType is only initialized when the first glyph is rasterized
+	FileView fontFile;
+	std::unique_ptr<FontRasterizer> rasterizer;
+	GlyphAtlas atlas;
 
 	GLuint VAO, VBO, EBO;
+	GPUMemory::Allocation gpuMemory;
+
+	// persistently mapped vertex buffer (ARB_buffer_storage), when not
+	// supported the quads are staged in memory and uploaded by flush()
+	Vertex* mapping;
+	std::vector<Vertex> staging;
+	GLsync fences[regionCount];
+	GLsizei region;
+	GLsizei quadCount;
+	Shader* batchShader;
+
+	// layouts drawn by the next flush
+	std::vector<TextLayout*> layouts;
+
+	Vertex* getRegion();
+
+	const GlyphAtlas::Glyph* getGlyph(char32_t codepoint);
+	const GlyphAtlas::Glyph* insertGlyph(char32_t codepoint);
+	static GLuint packColor(glm::vec3 color);
+	void shapeGlyph(const GlyphAtlas::Glyph& glyph, GLfloat& x, GLfloat y, GLfloat scale, GLuint color, Vertex* quad) const;
+	void setupVertexAttributes();
 
 	void deleteGLObjects();
 };
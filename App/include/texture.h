@@ -1,8 +1,12 @@
 #pragma once
+#include <cstddef>
 #include <string>
+#include <memory>
 #include <filesystem>
 #include <GL/glew.h>
 
+#include "gpuMemory.h"
+
 
 class Texture
 {
@@ -18,10 +22,25 @@ public:
 	Texture& operator=(const Texture& other) = delete;
 	Texture& operator=(Texture&& other) noexcept;
 
+	// shared texture from the asset registry, loaded if not loaded yet
+	static std::shared_ptr<Texture> load(
+		const std::filesystem::path& path,
+		const std::string& name
+	);
+
 	GLuint getId() const;
 	const std::string& getName() const;
 
+	// size of all mip levels in video memory, without the levels left out
+	// over the budget
+	std::size_t getMemorySize() const;
+	// largest mip levels left out, over the budget
+	unsigned int getSkippedLevels() const;
+
 private:
 	GLuint id;
 	std::string name;
+	std::size_t memorySize;
+	unsigned int skippedLevels;
+	GPUMemory::Allocation gpuMemory;
 };
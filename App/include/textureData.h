@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <GL/glew.h>
+
+#include "fileView.h"
+
+
+// CPU side result of decoding an image file into RGBA8 pixels, optionally
+// with a full mip chain; this is what the cooker stores and what Texture
+// uploads
+class TextureData
+{
+public:
+	struct Level
+	{
+		GLuint width;
+		GLuint height;
+		std::vector<std::uint8_t> pixels;
+	};
+
+	// level 0 is the full resolution image
+	std::vector<Level> levels;
+
+	// loads the cooked texture if one exists, decodes (and caches) it
+	// including its mip levels otherwise
+	static TextureData load(const std::filesystem::path& path);
+	static TextureData decode(const std::filesystem::path& path, bool generateMips);
+
+	std::vector<std::byte> serialize() const;
+	static TextureData deserialize(const FileView& data);
+	// empty instead of throwing when the data is corrupt
+	static std::optional<TextureData> tryDeserialize(const FileView& data);
+
+	// identifies processing steps and format version, part of the cooked key
+	static std::string params();
+
+private:
+	static constexpr std::uint32_t formatVersion = 1;
+
+	// box filtered 2x2 downsampling of an RGBA8 level
+	static Level downsample(const Level& level);
+};
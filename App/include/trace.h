@@ -0,0 +1,106 @@
+#pragma once
+
+// timeline of scopes, asset loads and frame boundaries of every thread,
+// written as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev)
+//
+// every thread records into its own ring buffer without locking, the most
+// recent eventsPerThread events of each thread are kept; a dump copies the
+// buffers while the threads keep recording
+//
+// the recorder only exists when the engine is built with
+// APP_ENABLE_TRACING (CMake option of the same name), otherwise the TRACE_
+// macros expand to nothing
+#ifdef APP_ENABLE_TRACING
+
+#include <cstdint>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <string_view>
+#include <filesystem>
+
+
+class Trace
+{
+public:
+	// names have to be string literals (or outlive the recorder), the
+	// argument is copied and truncated to its last argumentSize - 1 chars
+	static void begin(const char* name, std::string_view argument = {});
+	static void end();
+	static void instant(const char* name, std::string_view argument = {});
+
+	// marks a frame boundary; when the frame took longer than the hitch
+	// threshold, the trace is dumped to the output directory (at most once
+	// every hitchCooldown seconds)
+	static void frame();
+
+	// 0 disables dumps on hitches (default)
+	static void setHitchThreshold(double milliseconds);
+	static void setOutputDirectory(const std::filesystem::path& directory);
+
+	// shown instead of the thread id
+	static void setThreadName(const char* name);
+
+	// returns false if the file couldn't be written
+	static bool dump(const std::filesystem::path& path);
+
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name, std::string_view argument = {});
+		~Scope();
+
+		Scope(const Scope& other) = delete;
+		Scope& operator=(const Scope& other) = delete;
+	};
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr std::size_t eventsPerThread = 16384;
+	static constexpr std::size_t argumentSize = 48;
+	static constexpr double hitchCooldown = 10.0;
+
+	struct Event;
+	struct ThreadBuffer;
+
+	static const Clock::time_point startTime;
+
+	static std::mutex mutex;
+	static std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	static std::uint32_t nextThread;
+
+	// names are kept for threads whose buffer was reused
+	static std::vector<std::pair<std::uint32_t, const char*>> threadNames;
+
+	static double hitchThreshold;
+	static std::filesystem::path outputDirectory;
+
+	// frame() is called by the main thread only
+	static Clock::time_point lastFrame;
+	static Clock::time_point lastDump;
+	static bool dumpedHitch;
+	static std::uint64_t frameNumber;
+
+	static ThreadBuffer& getBuffer();
+	static void record(char phase, const char* name, std::string_view argument);
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#define TRACE_SCOPE(...) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+#define TRACE_INSTANT(...) Trace::instant(__VA_ARGS__)
+#define TRACE_FRAME() Trace::frame()
+#define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+
+#else
+
+#define TRACE_SCOPE(...) ((void)0)
+#define TRACE_INSTANT(...) ((void)0)
+#define TRACE_FRAME() ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+
+// replacement character for invalid input
+inline constexpr char32_t replacementCodepoint = 0xFFFD;
+
+// decodes the UTF-8 sequence starting at str[pos] and moves pos behind it;
+// invalid sequences (overlong encodings, surrogates, truncated sequences,
+// stray continuation bytes) decode to U+FFFD and skip a single byte
+inline char32_t decodeUtf8(std::string_view str, std::size_t& pos)
+{
+	unsigned char lead = static_cast<unsigned char>(str[pos++]);
+
+	if (lead < 0x80)
+		return lead;
+
+	std::size_t length;
+	char32_t codepoint;
+	char32_t min;
+
+	if ((lead & 0xE0) == 0xC0)
+	{
+		length = 1;
+		codepoint = lead & 0x1F;
+		min = 0x80;
+	}
+	else if ((lead & 0xF0) == 0xE0)
+	{
+		length = 2;
+		codepoint = lead & 0x0F;
+		min = 0x800;
+	}
+	else if ((lead & 0xF8) == 0xF0)
+	{
+		length = 3;
+		codepoint = lead & 0x07;
+		min = 0x10000;
+	}
+	else
+		return replacementCodepoint;
+
+	if (str.size() - pos < length)
+		return replacementCodepoint;
+
+	for (std::size_t i = 0; i < length; i++)
+	{
+		unsigned char next = static_cast<unsigned char>(str[pos + i]);
+		if ((next & 0xC0) != 0x80)
+			return replacementCodepoint;
+
+		codepoint = (codepoint << 6) | (next & 0x3F);
+	}
+
+	if (codepoint < min || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+		return replacementCodepoint;
+
+	pos += length;
+	return codepoint;
+}
@@ -7,7 +7,14 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "inputRecording.h"
+#include "gpuMemory.h"
 
+
+// a headless window has no surface and needs no display: the context is
+// created with EGL (surfaceless) or OSMesa on GLFW's null platform and
+// rendered into an offscreen framebuffer of the window's size, which stays
+// bound; update() doesn't swap buffers then
 class Window
 {
 public:
@@ -15,7 +22,8 @@ public:
 		int width, int height,
 		const std::string& title = "",
 		bool resizable = false,
-		bool debugContext = true
+		bool debugContext = true,
+		bool headless = false
 	);
 
 	Window(const Window& other) = delete;
@@ -31,7 +39,10 @@ public:
 	int getWidth() const;
 	int getHeight() const;
 	double getDeltaTime() const;
+	double getTime() const;
+	double getFrameTime() const;
 	int getFPS() const;
+	bool isHeadless() const;
 	bool getKeyStatus(int key) const;
 	double getCursorPosX() const;
 	double getCursorPosY() const;
@@ -41,6 +52,18 @@ public:
 	void setSize(int width, int height);
 	void update();
 
+	// appends the input events and delta times of every following frame to
+	// the recording until recording is stopped; the recording has to
+	// outlive the window or stopRecording()
+	void startRecording(InputRecording& recording);
+	void stopRecording();
+
+	// ignores real input and feeds the recorded events back instead, frame
+	// by frame; delta times are timestep seconds, or the recorded ones if
+	// timestep is 0; the window is closed when the recording ends
+	void startReplay(const InputRecording& recording, double timestep = 0.0);
+	bool isReplaying() const;
+
 	void addKeyCallback(std::function<void(Window*)> callback);
 	void addCursorPosCallback(std::function<void(Window*)> callback);
 	void addScrollCallback(std::function<void(Window*)> callback);
@@ -51,10 +74,35 @@ private:
 	int width;
 	int height;
 
+	// offscreen framebuffer of headless windows
+	bool headless;
+	GLuint framebuffer;
+	GLuint colorBuffer;
+	GLuint depthBuffer;
+	GPUMemory::Allocation framebufferMemory;
+
 	double previousTime;
 	double deltaTime;
 	int fps;
 
+	// time advanced by the delta times, replays advance it deterministically
+	double time;
+
+	// wall clock duration of the last frame, even when replaying
+	double frameTime;
+
+	// frames completed by update()
+	std::uint32_t frame;
+
+	InputRecording* recording;
+	const InputRecording* replay;
+	double replayTimestep;
+	std::size_t replayEvent;
+
+	// start and number of frames of the current FPS interval
+	double fpsStartTime;
+	int fpsFrameCount;
+
 	std::array<bool, GLFW_KEY_LAST+1> keys;
 	double cursorPosX;
 	double cursorPosY;
@@ -67,6 +115,13 @@ private:
 
 	static int instanceCount;
 
+	GLFWwindow* createHeadlessWindow(const std::string& title);
+	// returns false if the framebuffer is incomplete
+	bool createFramebuffer();
+	void deleteFramebuffer();
+
+	void replayFrame();
+
 	// OpenGL callback functions:
 	void debugMessageCallback(
 		GLenum source, GLenum type,
@@ -0,0 +1,286 @@
+#ifdef APP_ENABLE_ALLOCATION_TRACKING
+
+#include <new>
+#include <mutex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <algorithm>
+
+#include "allocationTracker.h"
+
+
+std::array<const char*, AllocationTracker::maxTags> AllocationTracker::names{ "untagged" };
+std::atomic<int> AllocationTracker::tagCount{ 1 };
+
+std::array<AllocationTracker::AtomicCounters, AllocationTracker::maxTags> AllocationTracker::counters{};
+std::array<AllocationTracker::Counters, AllocationTracker::maxTags> AllocationTracker::lastFrame{};
+std::array<AllocationTracker::Counters, AllocationTracker::maxTags> AllocationTracker::total{};
+std::uint64_t AllocationTracker::frameCount = 0;
+
+std::atomic<bool> AllocationTracker::assertMode{ false };
+std::atomic<std::uint64_t> AllocationTracker::hotViolations{ 0 };
+
+// trivially initialized, so operator new can use them at any time
+static thread_local int currentTag = 0;
+static thread_local int currentHotTag = -1;
+
+int AllocationTracker::tag(const char* name)
+{
+	// registering doesn't allocate, the names live in a fixed array
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	int count = tagCount.load(std::memory_order_relaxed);
+	for (int i = 0; i < count; i++)
+	{
+		if (std::strcmp(names[i], name) == 0)
+			return i;
+	}
+
+	if (count == maxTags)
+		return maxTags - 1;
+
+	names[count] = name;
+	tagCount.store(count + 1, std::memory_order_release);
+
+	return count;
+}
+
+AllocationTracker::Scope::Scope(int tag, Mode mode)
+	: previousTag{ currentTag }
+	, previousHotTag{ currentHotTag }
+{
+	currentTag = tag;
+
+	// scopes inside a hot scope stay hot
+	if (mode == HOT && currentHotTag < 0)
+		currentHotTag = tag;
+}
+
+AllocationTracker::Scope::~Scope()
+{
+	currentTag = previousTag;
+	currentHotTag = previousHotTag;
+}
+
+void AllocationTracker::record(std::size_t size)
+{
+	AtomicCounters& tagCounters = counters[currentTag];
+	tagCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+	tagCounters.bytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (currentHotTag < 0)
+		return;
+
+	hotViolations.fetch_add(1, std::memory_order_relaxed);
+
+	// printing with stdio, streams may allocate
+	if (assertMode.load(std::memory_order_relaxed))
+	{
+		std::fprintf(
+			stderr, "Error: AllocationTracker: %zu bytes allocated in hot scope %s (tag %s).\n",
+			size, names[currentHotTag], names[currentTag]
+		);
+		std::abort();
+	}
+}
+
+void AllocationTracker::frame()
+{
+	int count = tagCount.load(std::memory_order_acquire);
+
+	for (int i = 0; i < count; i++)
+	{
+		lastFrame[i].allocations = counters[i].allocations.exchange(0, std::memory_order_relaxed);
+		lastFrame[i].bytes = counters[i].bytes.exchange(0, std::memory_order_relaxed);
+
+		total[i].allocations += lastFrame[i].allocations;
+		total[i].bytes += lastFrame[i].bytes;
+	}
+
+	frameCount++;
+}
+
+void AllocationTracker::setAssertMode(bool enabled)
+{
+	assertMode = enabled;
+}
+
+std::uint64_t AllocationTracker::getHotViolations()
+{
+	return hotViolations;
+}
+
+AllocationTracker::Counters AllocationTracker::getLastFrame()
+{
+	Counters sum{};
+
+	int count = tagCount.load(std::memory_order_acquire);
+	for (int i = 0; i < count; i++)
+	{
+		sum.allocations += lastFrame[i].allocations;
+		sum.bytes += lastFrame[i].bytes;
+	}
+
+	return sum;
+}
+
+AllocationTracker::Counters AllocationTracker::getLastFrame(int tag)
+{
+	return lastFrame[tag];
+}
+
+void AllocationTracker::print(std::ostream& stream)
+{
+	int count = tagCount.load(std::memory_order_acquire);
+	double frames = static_cast<double>(std::max<std::uint64_t>(frameCount, 1));
+
+	stream
+		<< "Info: AllocationTracker: " << frameCount << " frames, "
+		<< hotViolations << " allocations in hot scopes" << std::endl
+		<< "Info: AllocationTracker: " << std::left << std::setw(16) << "tag" << std::right
+		<< std::setw(12) << "last allocs" << std::setw(12) << "last bytes"
+		<< std::setw(12) << "avg allocs" << std::setw(12) << "avg bytes"
+		<< std::setw(14) << "total bytes" << std::endl;
+
+	for (int i = 0; i < count; i++)
+	{
+		stream
+			<< "Info: AllocationTracker: " << std::left << std::setw(16) << names[i] << std::right
+			<< std::setw(12) << lastFrame[i].allocations << std::setw(12) << lastFrame[i].bytes
+			<< std::fixed << std::setprecision(1)
+			<< std::setw(12) << total[i].allocations / frames << std::setw(12) << total[i].bytes / frames
+			<< std::defaultfloat
+			<< std::setw(14) << total[i].bytes << std::endl;
+	}
+}
+
+// replaced global allocation functions, everything else (nothrow, array
+// and sized variants) is implemented by the standard library in terms of
+// these
+//
+// aligned is set by the align_val_t overloads, whose memory is freed by the
+// aligned operator delete: on Windows that is _aligned_free(), so it has to
+// come from _aligned_malloc() whatever the alignment
+static void* allocate(std::size_t size, std::size_t alignment, bool aligned)
+{
+	AllocationTracker::record(size);
+
+	if (size == 0)
+		size = 1;
+
+	while (true)
+	{
+		void* ptr;
+
+#ifdef _WIN32
+		if (!aligned)
+			ptr = std::malloc(size);
+		else
+			ptr = _aligned_malloc(size, alignment);
+#else
+		if (!aligned || alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			ptr = std::malloc(size);
+		else
+		{
+			// the size has to be a multiple of the alignment
+			ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+		}
+#endif
+
+		if (ptr != nullptr)
+			return ptr;
+
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+
+		handler();
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, false);
+}
+
+void* operator new[](std::size_t size)
+{
+	return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, false);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return allocate(size, static_cast<std::size_t>(alignment), true);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return allocate(size, static_cast<std::size_t>(alignment), true);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+#ifdef _WIN32
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	_aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	_aligned_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	_aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	_aligned_free(ptr);
+}
+#else
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "assetIOSystem.h"
+#include "assets.h"
+
+
+AssetIOStream::AssetIOStream(FileView&& view)
+	: view{ std::move(view) }
+	, pos{ 0 }
+{
+
+}
+
+std::size_t AssetIOStream::Read(void* buffer, std::size_t size, std::size_t count)
+{
+	if (size == 0 || count == 0)
+		return 0;
+
+	// like fread(), only whole elements are read
+	count = std::min(count, (view.size() - pos) / size);
+	std::memcpy(buffer, view.data() + pos, size * count);
+	pos += size * count;
+
+	return count;
+}
+
+std::size_t AssetIOStream::Write(const void* buffer, std::size_t size, std::size_t count)
+{
+	// read-only stream
+	return 0;
+}
+
+aiReturn AssetIOStream::Seek(std::size_t offset, aiOrigin origin)
+{
+	std::size_t newPos;
+
+	switch (origin)
+	{
+	case aiOrigin_SET:
+		newPos = offset;
+		break;
+	case aiOrigin_CUR:
+		newPos = pos + offset;
+		break;
+	case aiOrigin_END:
+		newPos = view.size() - offset;
+		break;
+	default:
+		return aiReturn_FAILURE;
+	}
+
+	if (newPos > view.size())
+		return aiReturn_FAILURE;
+
+	pos = newPos;
+	return aiReturn_SUCCESS;
+}
+
+std::size_t AssetIOStream::Tell() const
+{
+	return pos;
+}
+
+std::size_t AssetIOStream::FileSize() const
+{
+	return view.size();
+}
+
+void AssetIOStream::Flush()
+{
+
+}
+
+bool AssetIOSystem::Exists(const char* file) const
+{
+	return Assets::exists(file);
+}
+
+char AssetIOSystem::getOsSeparator() const
+{
+	return static_cast<char>(std::filesystem::path::preferred_separator);
+}
+
+Assimp::IOStream* AssetIOSystem::Open(const char* file, const char* mode)
+{
+	// only reading is supported
+	if (std::strchr(mode, 'w') || std::strchr(mode, 'a') || std::strchr(mode, '+'))
+		return nullptr;
+
+	// assimp expects nullptr instead of an exception when a file can't be opened
+	Assimp::IOStream* stream;
+	try { stream = new AssetIOStream(Assets::open(file, FileView::SEQUENTIAL)); }
+	catch (const std::runtime_error&) { return nullptr; }
+
+	openedFiles.push_back(file);
+	return stream;
+}
+
+void AssetIOSystem::Close(Assimp::IOStream* file)
+{
+	delete file;
+}
+
+const std::vector<std::string>& AssetIOSystem::getOpenedFiles() const
+{
+	return openedFiles;
+}
@@ -0,0 +1,257 @@
+#include <cstring>
+#include <bit>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+#include <stdexcept>
+
+#include "assetPack.h"
+#include "hash.h"
+
+
+static_assert(
+	std::endian::native == std::endian::little,
+	"Assertion failed: Asset packs are only supported on little endian systems."
+);
+
+AssetPack::AssetPack(const std::filesystem::path& packPath)
+	: file{ std::make_shared<const FileView>(packPath, FileView::RANDOM) }
+	, header{ nullptr }
+	, entries{ nullptr }
+	, strings{ nullptr }
+{
+	std::stringstream errorMessage;
+	errorMessage << "Error: AssetPack::AssetPack(): ";
+
+	if (file->size() < sizeof(Header))
+	{
+		errorMessage << "File " << packPath << " is too small to be an asset pack." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	header = reinterpret_cast<const Header*>(file->data());
+
+	if (std::memcmp(header->magic, packMagic, sizeof(packMagic)) != 0 || header->version != packVersion)
+	{
+		errorMessage << "File " << packPath << " is not a supported asset pack." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	if (header->indexOffset % alignof(Entry) != 0 ||
+		header->indexOffset > file->size() ||
+		header->entryCount > (file->size() - header->indexOffset) / sizeof(Entry) ||
+		header->stringsOffset > file->size() ||
+		header->stringsSize > file->size() - header->stringsOffset)
+	{
+		errorMessage << "Index of asset pack " << packPath << " is corrupt." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	entries = reinterpret_cast<const Entry*>(file->data() + header->indexOffset);
+	strings = reinterpret_cast<const char*>(file->data() + header->stringsOffset);
+
+	for (std::uint64_t i = 0; i < header->entryCount; i++)
+	{
+		const Entry& entry = entries[i];
+
+		if (entry.offset > file->size() ||
+			entry.size > file->size() - entry.offset ||
+			entry.pathOffset > header->stringsSize ||
+			entry.pathLength > header->stringsSize - entry.pathOffset)
+		{
+			errorMessage << "Entry " << i << " of asset pack " << packPath << " is corrupt." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+	}
+}
+
+bool AssetPack::contains(const std::filesystem::path& path) const
+{
+	return find(normalize(path)) != nullptr;
+}
+
+FileView AssetPack::open(const std::filesystem::path& path, FileView::Access access) const
+{
+	std::string key = normalize(path);
+	const Entry* entry = find(key);
+
+	if (entry == nullptr)
+	{
+		std::stringstream errorMessage;
+		errorMessage
+			<< "Error: AssetPack::open(): "
+			<< path << " not found in asset pack " << file->getPath() << "." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	if (entry->codec == Compression::NONE)
+	{
+		FileView view(file, entry->offset, entry->size, key);
+		view.advise(access);
+		return view;
+	}
+
+	std::vector<std::byte> buffer(entry->originalSize);
+	Compression::decompress(
+		static_cast<Compression::Codec>(entry->codec),
+		file->data() + entry->offset, entry->size,
+		buffer.data(), buffer.size()
+	);
+
+	return FileView(std::move(buffer), key);
+}
+
+std::size_t AssetPack::getEntryCount() const
+{
+	return header->entryCount;
+}
+
+const std::filesystem::path& AssetPack::getPath() const
+{
+	return file->getPath();
+}
+
+void AssetPack::build(
+	const std::filesystem::path& packPath,
+	const std::vector<Input>& inputs,
+	Compression::Codec codec,
+	int level
+)
+{
+	std::stringstream errorMessage;
+	errorMessage << "Error: AssetPack::build(): ";
+
+	std::vector<Entry> index;
+	std::string pathStrings;
+	std::unordered_set<std::string> keys;
+
+	// write to a temporary file first, so a failed build never leaves
+	// a truncated pack behind
+	std::filesystem::path tmpPath = packPath;
+	tmpPath += ".tmp";
+
+	std::ofstream pack;
+	pack.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+
+	try
+	{
+		if (packPath.has_parent_path())
+			std::filesystem::create_directories(packPath.parent_path());
+
+		pack.open(tmpPath, std::ios::binary | std::ios::trunc);
+
+		// the header is written last, when all offsets are known
+		Header packHeader = {};
+		pack.write(reinterpret_cast<const char*>(&packHeader), sizeof(packHeader));
+
+		for (const Input& input : inputs)
+		{
+			std::string key = normalize(input.path);
+			if (!keys.insert(key).second)
+				continue;
+
+			FileView source(input.file, FileView::SEQUENTIAL);
+
+			Entry entry = {};
+			entry.hash = hash64(key);
+			entry.originalSize = source.size();
+			entry.pathOffset = static_cast<std::uint32_t>(pathStrings.size());
+			entry.pathLength = static_cast<std::uint32_t>(key.size());
+			entry.codec = Compression::NONE;
+
+			std::vector<std::byte> compressed;
+			if (codec != Compression::NONE && !source.empty())
+			{
+				compressed = Compression::compress(codec, source.data(), source.size(), level);
+
+				// already compressed formats (.jpg, .png, ...) are stored as is
+				if (compressed.size() < source.size() - source.size() / 20)
+					entry.codec = codec;
+			}
+
+			const std::byte* data = entry.codec == Compression::NONE ? source.data() : compressed.data();
+			entry.size = entry.codec == Compression::NONE ? source.size() : compressed.size();
+
+			// align entries, so uncompressed data can be used in place
+			std::uint64_t offset = static_cast<std::uint64_t>(pack.tellp());
+			std::uint64_t padding = (16 - offset % 16) % 16;
+			const char zeros[16] = {};
+			pack.write(zeros, padding);
+
+			entry.offset = offset + padding;
+			pack.write(reinterpret_cast<const char*>(data), entry.size);
+
+			index.push_back(entry);
+			pathStrings += key;
+		}
+
+		std::sort(index.begin(), index.end(),
+			[](const Entry& a, const Entry& b) { return a.hash < b.hash; }
+		);
+
+		std::uint64_t offset = static_cast<std::uint64_t>(pack.tellp());
+		std::uint64_t padding = (alignof(Entry) - offset % alignof(Entry)) % alignof(Entry);
+		const char zeros[alignof(Entry)] = {};
+		pack.write(zeros, padding);
+
+		std::memcpy(packHeader.magic, packMagic, sizeof(packMagic));
+		packHeader.version = packVersion;
+		packHeader.entryCount = index.size();
+		packHeader.indexOffset = offset + padding;
+		packHeader.stringsOffset = packHeader.indexOffset + index.size() * sizeof(Entry);
+		packHeader.stringsSize = pathStrings.size();
+
+		pack.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Entry));
+		pack.write(pathStrings.data(), pathStrings.size());
+
+		pack.seekp(0);
+		pack.write(reinterpret_cast<const char*>(&packHeader), sizeof(packHeader));
+		pack.close();
+
+		std::filesystem::rename(tmpPath, packPath);
+	}
+	catch (const std::exception& e)
+	{
+		if (pack.is_open())
+			pack.close();
+
+		std::error_code error;
+		std::filesystem::remove(tmpPath, error);
+
+		errorMessage << "Building asset pack " << packPath << " failed with: " << e.what() << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+}
+
+std::string AssetPack::normalize(const std::filesystem::path& path)
+{
+	std::string key = path.lexically_normal().generic_string();
+
+	while (key.starts_with("./"))
+		key.erase(0, 2);
+
+	return key;
+}
+
+const AssetPack::Entry* AssetPack::find(const std::string& key) const
+{
+	std::uint64_t hash = hash64(key);
+
+	const Entry* begin = entries;
+	const Entry* end = entries + header->entryCount;
+
+	const Entry* it = std::lower_bound(begin, end, hash,
+		[](const Entry& entry, std::uint64_t hash) { return entry.hash < hash; }
+	);
+
+	// compare the paths as well to resolve hash collisions
+	for (; it != end && it->hash == hash; it++)
+	{
+		if (std::string_view(strings + it->pathOffset, it->pathLength) == key)
+			return it;
+	}
+
+	return nullptr;
+}
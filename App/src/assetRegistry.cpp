@@ -0,0 +1,155 @@
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+
+#include "assetRegistry.h"
+#include "assets.h"
+#include "hash.h"
+
+
+std::mutex AssetRegistry::mutex;
+std::unordered_map<std::uint64_t, AssetRegistry::Record> AssetRegistry::records;
+
+std::uint64_t AssetRegistry::contentHash(const std::filesystem::path& path)
+{
+	try
+	{
+		FileView file = Assets::open(path, FileView::SEQUENTIAL);
+		return hash64(file.data(), file.size());
+	}
+	catch (const std::runtime_error&)
+	{
+		return 0;
+	}
+}
+
+std::vector<AssetRegistry::Info> AssetRegistry::getInfo()
+{
+	std::vector<Info> info;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (auto it = records.begin(); it != records.end();)
+		{
+			const Record& record = it->second;
+			std::shared_ptr<const void> asset = record.asset.lock();
+
+			if (!asset)
+			{
+				it = records.erase(it);
+				continue;
+			}
+
+			// the reference held here for the duration of the query is not
+			// counted
+			info.push_back({
+				record.type,
+				record.path,
+				record.contentHash,
+				asset.use_count() - 1,
+				record.memorySize(asset.get())
+			});
+
+			it++;
+		}
+	}
+
+	std::sort(info.begin(), info.end(), [](const Info& a, const Info& b)
+	{
+		return a.type != b.type ? a.type < b.type : a.path < b.path;
+	});
+
+	return info;
+}
+
+void AssetRegistry::printInfo(std::ostream& stream)
+{
+	std::size_t totalSize = 0;
+	std::vector<Info> info = getInfo();
+
+	for (const Info& asset : info)
+	{
+		stream
+			<< "Info: AssetRegistry: " << toString(asset.type) << " " << asset.path
+			<< " (" << std::setfill('0') << std::setw(16) << std::hex << asset.contentHash
+			<< std::dec << std::setfill(' ') << "): "
+			<< asset.useCount << " references, "
+			<< asset.memorySize << " bytes" << std::endl;
+
+		// models consist of meshes and textures, which are listed on their own
+		if (asset.type != MODEL)
+			totalSize += asset.memorySize;
+	}
+
+	stream
+		<< "Info: AssetRegistry: " << info.size() << " assets, "
+		<< totalSize << " bytes" << std::endl;
+}
+
+const char* AssetRegistry::toString(Type type)
+{
+	switch (type)
+	{
+	case TEXTURE:
+		return "texture";
+	case MESH:
+		return "mesh";
+	case MODEL:
+		return "model";
+	default:
+		return "unknown";
+	}
+}
+
+std::uint64_t AssetRegistry::key(Type type, std::string_view path, std::uint64_t contentHash)
+{
+	return hash64(path, contentHash ^ (static_cast<std::uint64_t>(type) << 56));
+}
+
+std::shared_ptr<const void> AssetRegistry::find(std::uint64_t key, Type type, std::string_view path, std::uint64_t contentHash)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = records.find(key);
+	if (it == records.end())
+		return nullptr;
+
+	const Record& record = it->second;
+	if (record.type != type || record.path != path || record.contentHash != contentHash)
+		return nullptr;
+
+	std::shared_ptr<const void> asset = it->second.asset.lock();
+
+	// released assets are removed lazily
+	if (!asset)
+		records.erase(it);
+
+	return asset;
+}
+
+std::shared_ptr<const void> AssetRegistry::insert(std::uint64_t key, Record&& record, std::shared_ptr<const void> asset)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = records.find(key);
+	if (it != records.end())
+	{
+		if (std::shared_ptr<const void> registered = it->second.asset.lock())
+		{
+			const Record& other = it->second;
+
+			// another asset under the same key keeps its place, this one
+			// isn't shared
+			if (other.type != record.type || other.path != record.path || other.contentHash != record.contentHash)
+				return asset;
+
+			return registered;
+		}
+	}
+
+	record.asset = asset;
+	records.insert_or_assign(key, std::move(record));
+
+	return asset;
+}
@@ -0,0 +1,36 @@
+#include "assets.h"
+
+
+std::unique_ptr<AssetPack> Assets::pack;
+
+void Assets::mountPack(const std::filesystem::path& packPath)
+{
+	pack = std::make_unique<AssetPack>(packPath);
+}
+
+void Assets::unmountPack()
+{
+	pack.reset();
+}
+
+bool Assets::isPackMounted()
+{
+	return pack != nullptr;
+}
+
+bool Assets::exists(const std::filesystem::path& path)
+{
+	if (pack && pack->contains(path))
+		return true;
+
+	std::error_code error;
+	return std::filesystem::is_regular_file(path, error);
+}
+
+FileView Assets::open(const std::filesystem::path& path, FileView::Access access)
+{
+	if (pack && pack->contains(path))
+		return pack->open(path, access);
+
+	return FileView(path, access);
+}
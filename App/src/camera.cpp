@@ -23,6 +23,9 @@ Camera::Camera(
 	, speed{ 1.0f }
 	, speedMultiplicator{ 4.0f }
 	, sensitivity{ 0.1f }
+	, cursorKnown{ false }
+	, lastCursorX{ 0.0f }
+	, lastCursorY{ 0.0f }
 {
 	setTarget(target);
 }
@@ -210,14 +213,18 @@ void Camera::cursorPosCallback(Window* window)
 	GLfloat posX = static_cast<GLfloat>(window->getCursorPosX());
 	GLfloat posY = static_cast<GLfloat>(window->getCursorPosY());
 
-	static double lastX = posX;
-	static double lastY = posY;
+	if (!cursorKnown)
+	{
+		cursorKnown = true;
+		lastCursorX = posX;
+		lastCursorY = posY;
+	}
 
-	GLfloat deltaX = posX - lastX;
-	GLfloat deltaY = posY - lastY;
+	GLfloat deltaX = posX - lastCursorX;
+	GLfloat deltaY = posY - lastCursorY;
 
-	lastX = posX;
-	lastY = posY;
+	lastCursorX = posX;
+	lastCursorY = posY;
 
 	yaw += deltaX * sensitivity;
 	pitch += deltaY * sensitivity;
@@ -0,0 +1,193 @@
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zstd.h>
+
+#include "compression.h"
+
+
+std::vector<std::byte> Compression::compress(
+	Codec codec,
+	const std::byte* data, std::size_t size,
+	int level
+)
+{
+	std::stringstream errorMessage;
+	errorMessage << "Error: Compression::compress(): ";
+
+	std::vector<std::byte> result;
+
+	switch (codec)
+	{
+	case NONE:
+	{
+		result.assign(data, data + size);
+		break;
+	}
+	case LZ4:
+	{
+		if (size > LZ4_MAX_INPUT_SIZE)
+		{
+			errorMessage << "Input too large for LZ4." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+
+		result.resize(LZ4_compressBound(static_cast<int>(size)));
+
+		const char* src = reinterpret_cast<const char*>(data);
+		char* dst = reinterpret_cast<char*>(result.data());
+		int srcSize = static_cast<int>(size);
+		int dstCapacity = static_cast<int>(result.size());
+
+		int compressedSize = level > 0
+			? LZ4_compress_HC(src, dst, srcSize, dstCapacity, level)
+			: LZ4_compress_default(src, dst, srcSize, dstCapacity);
+
+		if (compressedSize <= 0 && size > 0)
+		{
+			errorMessage << "LZ4 compression failed." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+
+		result.resize(compressedSize);
+		break;
+	}
+	case ZSTD:
+	{
+		result.resize(ZSTD_compressBound(size));
+
+		std::size_t compressedSize = ZSTD_compress(
+			result.data(), result.size(), data, size,
+			level > 0 ? level : ZSTD_CLEVEL_DEFAULT
+		);
+
+		if (ZSTD_isError(compressedSize))
+		{
+			errorMessage << "Zstd compression failed with: "
+				<< ZSTD_getErrorName(compressedSize) << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+
+		result.resize(compressedSize);
+		break;
+	}
+	default:
+		errorMessage << "Unknown codec." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	return result;
+}
+
+void Compression::decompress(
+	Codec codec,
+	const std::byte* src, std::size_t srcSize,
+	std::byte* dst, std::size_t dstSize
+)
+{
+	std::stringstream errorMessage;
+	errorMessage << "Error: Compression::decompress(): ";
+
+	switch (codec)
+	{
+	case NONE:
+	{
+		if (srcSize != dstSize)
+		{
+			errorMessage << "Size mismatch for uncompressed data." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+
+		if (srcSize > 0)
+			std::memcpy(dst, src, srcSize);
+		break;
+	}
+	case LZ4:
+	{
+		int decompressedSize = LZ4_decompress_safe(
+			reinterpret_cast<const char*>(src),
+			reinterpret_cast<char*>(dst),
+			static_cast<int>(srcSize),
+			static_cast<int>(dstSize)
+		);
+
+		if (decompressedSize < 0 || static_cast<std::size_t>(decompressedSize) != dstSize)
+		{
+			errorMessage << "LZ4 decompression failed." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+		break;
+	}
+	case ZSTD:
+	{
+		std::size_t decompressedSize = ZSTD_decompress(dst, dstSize, src, srcSize);
+
+		if (ZSTD_isError(decompressedSize) || decompressedSize != dstSize)
+		{
+			errorMessage << "Zstd decompression failed." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+		break;
+	}
+	default:
+		errorMessage << "Unknown codec." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+}
+
+std::uint64_t Compression::decompressBound(
+	Codec codec,
+	const std::byte* src, std::size_t srcSize
+)
+{
+	switch (codec)
+	{
+	case NONE:
+		return srcSize;
+	case LZ4:
+		// a sequence of a few bytes copies at most 255 bytes per length byte
+		return static_cast<std::uint64_t>(srcSize) * 255;
+	case ZSTD:
+	{
+		unsigned long long contentSize = ZSTD_getFrameContentSize(src, srcSize);
+
+		if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == ZSTD_CONTENTSIZE_ERROR)
+			return 0;
+
+		return contentSize;
+	}
+	default:
+		return 0;
+	}
+}
+
+std::string Compression::toString(Codec codec)
+{
+	switch (codec)
+	{
+	case NONE:
+		return "none";
+	case LZ4:
+		return "lz4";
+	case ZSTD:
+		return "zstd";
+	default:
+		return "unknown";
+	}
+}
+
+Compression::Codec Compression::fromString(const std::string& str)
+{
+	if (str == "none")
+		return NONE;
+	if (str == "lz4")
+		return LZ4;
+	if (str == "zstd")
+		return ZSTD;
+
+	std::stringstream errorMessage;
+	errorMessage << "Error: Compression::fromString(): Unknown codec \"" << str << "\"." << std::endl;
+	throw std::runtime_error(errorMessage.str());
+}
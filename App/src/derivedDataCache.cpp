@@ -0,0 +1,337 @@
+#include <new>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+
+#include "derivedDataCache.h"
+#include "compression.h"
+#include "assets.h"
+#include "hash.h"
+
+
+std::filesystem::path DerivedDataCache::directory = "cooked";
+std::uint64_t DerivedDataCache::sizeLimit = 512ull << 20;
+
+std::mutex DerivedDataCache::mutex;
+std::map<std::filesystem::path, DerivedDataCache::Entry> DerivedDataCache::entries;
+std::uint64_t DerivedDataCache::totalSize = 0;
+bool DerivedDataCache::scanned = false;
+
+std::map<std::string, DerivedDataCache::Statistics, std::less<>> DerivedDataCache::statistics;
+
+void DerivedDataCache::setDirectory(const std::filesystem::path& directory)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	DerivedDataCache::directory = directory;
+
+	// the new directory is scanned on next use
+	entries.clear();
+	totalSize = 0;
+	scanned = false;
+}
+
+const std::filesystem::path& DerivedDataCache::getDirectory()
+{
+	return directory;
+}
+
+void DerivedDataCache::setSizeLimit(std::uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	sizeLimit = bytes;
+}
+
+std::uint64_t DerivedDataCache::getSizeLimit()
+{
+	return sizeLimit;
+}
+
+std::uint64_t DerivedDataCache::key(const FileView& source, std::string_view params)
+{
+	return hash64(source.data(), source.size(), hash64(params));
+}
+
+std::uint64_t DerivedDataCache::key(std::span<const FileView> sources, std::string_view params)
+{
+	// every source is hashed with the previous hash as seed, so the key
+	// depends on the order of the sources as well
+	std::uint64_t key = hash64(params);
+
+	for (const FileView& source : sources)
+		key = hash64(source.data(), source.size(), key);
+
+	return key;
+}
+
+std::filesystem::path DerivedDataCache::path(std::uint64_t key, std::string_view kind)
+{
+	std::stringstream name;
+	name << std::setfill('0') << std::setw(16) << std::hex << key << "." << kind;
+	return directory / name.str();
+}
+
+std::optional<FileView> DerivedDataCache::load(std::uint64_t key, std::string_view kind)
+{
+	std::filesystem::path entryPath = path(key, kind);
+
+	auto miss = [&]() -> std::optional<FileView>
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		statistics[std::string(kind)].misses++;
+		return std::nullopt;
+	};
+
+	if (!Assets::exists(entryPath))
+		return miss();
+
+	FileView file;
+
+	try { file = Assets::open(entryPath, FileView::SEQUENTIAL); }
+	catch (const std::runtime_error&)
+	{
+		return miss();
+	}
+
+	// a corrupt or foreign file is treated like a missing one
+	if (file.size() < sizeof(Header))
+		return miss();
+
+	Header header;
+	std::memcpy(&header, file.data(), sizeof(Header));
+
+	if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+		header.version != cacheVersion || header.key != key)
+		return miss();
+
+	// the size is checked against the data before it is allocated, a
+	// corrupt header must not ask for more than the data can hold
+	Compression::Codec codec = static_cast<Compression::Codec>(header.codec);
+	const std::byte* data = file.data() + sizeof(Header);
+	std::size_t dataSize = file.size() - sizeof(Header);
+
+	std::uint64_t bound = Compression::decompressBound(codec, data, dataSize);
+	if (header.size > bound)
+		return miss();
+
+	std::vector<std::byte> buffer;
+
+	try
+	{
+		buffer.resize(header.size);
+		Compression::decompress(codec, data, dataSize, buffer.data(), buffer.size());
+	}
+	catch (const std::runtime_error&)
+	{
+		return miss();
+	}
+	catch (const std::bad_alloc&)
+	{
+		return miss();
+	}
+	catch (const std::length_error&)
+	{
+		return miss();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Statistics& stats = statistics[std::string(kind)];
+		stats.hits++;
+		stats.bytesLoaded += buffer.size();
+
+		touch(entryPath);
+	}
+
+	return FileView(std::move(buffer), entryPath);
+}
+
+void DerivedDataCache::reject(std::string_view kind)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Statistics& stats = statistics[std::string(kind)];
+	stats.hits--;
+	stats.misses++;
+}
+
+void DerivedDataCache::store(std::uint64_t key, std::string_view kind, const std::vector<std::byte>& data)
+{
+	std::filesystem::path entryPath = path(key, kind);
+
+	Header header = {};
+	std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.version = cacheVersion;
+	header.key = key;
+	header.size = data.size();
+	header.codec = Compression::ZSTD;
+
+	std::vector<std::byte> compressed = Compression::compress(Compression::ZSTD, data.data(), data.size());
+
+	// the entry is written to a temporary file first, which is renamed when
+	// complete; other processes (and threads) either see no entry or a
+	// complete one, never a partially written one
+	//
+	// the cooker and several instances of the app may share the directory,
+	// so the name is unique across processes (a random number drawn once per
+	// process) and within the process (a counter)
+	static const std::uint64_t processTag = (std::uint64_t(std::random_device{}()) << 32) | std::random_device{}();
+	static std::atomic<std::uint64_t> tmpCount{ 0 };
+
+	std::stringstream tmpSuffix;
+	tmpSuffix << ".tmp" << std::hex << processTag << "-" << tmpCount.fetch_add(1);
+
+	std::filesystem::path tmpPath = entryPath;
+	tmpPath += tmpSuffix.str();
+
+	std::ofstream file;
+	file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+
+	try
+	{
+		std::filesystem::create_directories(entryPath.parent_path());
+
+		file.open(tmpPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+		file.close();
+
+		std::filesystem::rename(tmpPath, entryPath);
+	}
+	catch (const std::exception&)
+	{
+		std::error_code error;
+		std::filesystem::remove(tmpPath, error);
+
+		std::stringstream errorMessage;
+		errorMessage << "Error: DerivedDataCache::store(): Writing file " << entryPath << " failed." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Statistics& stats = statistics[std::string(kind)];
+	stats.stores++;
+	stats.bytesStored += sizeof(Header) + compressed.size();
+
+	scan();
+
+	// an entry that is stored again replaces the previous one
+	std::uint64_t size = sizeof(Header) + compressed.size();
+	auto it = entries.find(entryPath);
+
+	if (it != entries.end())
+		totalSize -= it->second.size;
+
+	entries[entryPath] = { size, std::filesystem::file_time_type::clock::now() };
+	totalSize += size;
+
+	evict(entryPath);
+}
+
+std::map<std::string, DerivedDataCache::Statistics> DerivedDataCache::getStatistics()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::map<std::string, Statistics>(statistics.begin(), statistics.end());
+}
+
+void DerivedDataCache::printStatistics(std::ostream& stream)
+{
+	for (const auto& [kind, stats] : getStatistics())
+	{
+		stream
+			<< "Info: DerivedDataCache: " << kind << ": "
+			<< stats.hits << " hits, "
+			<< stats.misses << " misses, "
+			<< stats.stores << " stores, "
+			<< stats.evictions << " evictions, "
+			<< stats.bytesLoaded << " bytes loaded, "
+			<< stats.bytesStored << " bytes stored" << std::endl;
+	}
+}
+
+void DerivedDataCache::scan()
+{
+	if (scanned)
+		return;
+
+	scanned = true;
+
+	std::error_code error;
+	if (!std::filesystem::is_directory(directory, error))
+		return;
+
+	for (const auto& file : std::filesystem::directory_iterator(directory, error))
+	{
+		// temporary files of interrupted writes and anything that isn't an
+		// entry (like the manifest of the cooker) are ignored
+		if (!file.is_regular_file(error) || file.path().extension().string().starts_with(".tmp") ||
+			file.path().stem().string().size() != 16)
+			continue;
+
+		Entry entry = { file.file_size(error), file.last_write_time(error) };
+		if (error)
+			continue;
+
+		entries[file.path()] = entry;
+		totalSize += entry.size;
+	}
+}
+
+void DerivedDataCache::touch(const std::filesystem::path& entryPath)
+{
+	// entries that are read from the asset pack are not part of the cache
+	// directory; the last access time is stored as modification time of
+	// the file, access times are not reliably updated by all file systems
+	scan();
+
+	auto it = entries.find(entryPath);
+	if (it == entries.end())
+		return;
+
+	it->second.lastAccess = std::filesystem::file_time_type::clock::now();
+
+	std::error_code error;
+	std::filesystem::last_write_time(entryPath, it->second.lastAccess, error);
+}
+
+void DerivedDataCache::evict(const std::filesystem::path& keep)
+{
+	if (sizeLimit == 0 || totalSize <= sizeLimit)
+		return;
+
+	std::vector<std::map<std::filesystem::path, Entry>::iterator> candidates;
+	for (auto it = entries.begin(); it != entries.end(); it++)
+	{
+		if (it->first != keep)
+			candidates.push_back(it);
+	}
+
+	std::sort(candidates.begin(), candidates.end(),
+		[](const auto& a, const auto& b) { return a->second.lastAccess < b->second.lastAccess; }
+	);
+
+	for (const auto& it : candidates)
+	{
+		if (totalSize <= sizeLimit)
+			break;
+
+		std::error_code error;
+		std::filesystem::remove(it->first, error);
+
+		if (error)
+			continue;
+
+		// the kind of an entry is its extension
+		statistics[it->first.extension().string().substr(1)].evictions++;
+
+		totalSize -= it->second.size;
+		entries.erase(it);
+	}
+}
@@ -0,0 +1,288 @@
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#include "fileView.h"
+
+
+FileView::FileView()
+	: ptr{ nullptr }
+	, length{ 0 }
+	, mapping{ nullptr }
+	, mappingLength{ 0 }
+{
+
+}
+
+FileView::FileView(const std::filesystem::path& path, Access access)
+	: path{ path }
+	, ptr{ nullptr }
+	, length{ 0 }
+	, mapping{ nullptr }
+	, mappingLength{ 0 }
+{
+	std::stringstream errorMessage;
+	errorMessage << "Error: FileView::FileView(): ";
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(
+		path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		access == SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS,
+		nullptr
+	);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		errorMessage << "Opening file " << path << " failed." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		errorMessage << "Querying size of file " << path << " failed." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	length = static_cast<std::size_t>(fileSize.QuadPart);
+
+	// empty files can't be mapped, an empty view is returned instead
+	if (length > 0)
+	{
+		HANDLE fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (fileMapping != nullptr)
+		{
+			mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(fileMapping);
+		}
+	}
+
+	// the view keeps the mapping alive, the handles are not needed anymore
+	CloseHandle(file);
+
+	if (length > 0 && mapping == nullptr)
+	{
+		errorMessage << "Mapping file " << path << " failed." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+#else
+	int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file == -1)
+	{
+		errorMessage << "Opening file " << path << " failed." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) == -1)
+	{
+		close(file);
+		errorMessage << "Querying size of file " << path << " failed." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	length = static_cast<std::size_t>(fileStat.st_size);
+
+	// empty files can't be mapped, an empty view is returned instead
+	if (length > 0)
+	{
+		void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+		if (address != MAP_FAILED)
+			mapping = address;
+	}
+
+	// the view keeps the mapping alive, the descriptor is not needed anymore
+	close(file);
+
+	if (length > 0 && mapping == nullptr)
+	{
+		errorMessage << "Mapping file " << path << " failed." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+#endif
+
+	ptr = static_cast<const std::byte*>(mapping);
+	mappingLength = length;
+
+	advise(access);
+}
+
+FileView::FileView(
+	std::shared_ptr<const FileView> parent,
+	std::size_t offset, std::size_t size,
+	const std::filesystem::path& path
+)
+	: path{ path }
+	, ptr{ nullptr }
+	, length{ 0 }
+	, mapping{ nullptr }
+	, mappingLength{ 0 }
+	, parent{ std::move(parent) }
+{
+	if (!this->parent || offset > this->parent->size() || size > this->parent->size() - offset)
+	{
+		std::stringstream errorMessage;
+		errorMessage
+			<< "Error: FileView::FileView(): Range of "
+			<< path << " exceeds its parent view." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	ptr = this->parent->data() + offset;
+	length = size;
+}
+
+FileView::FileView(std::vector<std::byte>&& buffer, const std::filesystem::path& path)
+	: path{ path }
+	, ptr{ nullptr }
+	, length{ 0 }
+	, mapping{ nullptr }
+	, mappingLength{ 0 }
+	, buffer{ std::move(buffer) }
+{
+	ptr = this->buffer.data();
+	length = this->buffer.size();
+}
+
+FileView::FileView(FileView&& other) noexcept
+	: path{ std::move(other.path) }
+	, ptr{ other.ptr }
+	, length{ other.length }
+	, mapping{ other.mapping }
+	, mappingLength{ other.mappingLength }
+	, parent{ std::move(other.parent) }
+	, buffer{ std::move(other.buffer) }
+{
+	other.ptr = nullptr;
+	other.length = 0;
+	other.mapping = nullptr;
+	other.mappingLength = 0;
+}
+
+FileView::~FileView()
+{
+	unmap();
+}
+
+FileView& FileView::operator=(FileView&& other) noexcept
+{
+	if (this != &other)
+	{
+		unmap();
+
+		path = std::move(other.path);
+		ptr = other.ptr;
+		length = other.length;
+		mapping = other.mapping;
+		mappingLength = other.mappingLength;
+		parent = std::move(other.parent);
+		buffer = std::move(other.buffer);
+
+		other.ptr = nullptr;
+		other.length = 0;
+		other.mapping = nullptr;
+		other.mappingLength = 0;
+	}
+
+	return *this;
+}
+
+const std::byte* FileView::data() const
+{
+	return ptr;
+}
+
+std::size_t FileView::size() const
+{
+	return length;
+}
+
+bool FileView::empty() const
+{
+	return length == 0;
+}
+
+std::string_view FileView::str() const
+{
+	return std::string_view(reinterpret_cast<const char*>(ptr), length);
+}
+
+const std::filesystem::path& FileView::getPath() const
+{
+	return path;
+}
+
+void FileView::advise(Access access) const
+{
+	// owned buffers are already in memory
+	if (ptr == nullptr || length == 0 || !buffer.empty())
+		return;
+
+#ifdef _WIN32
+	// windows has no equivalent for madvise() on mapped views, the access
+	// pattern is passed as a flag when opening the file instead; WILLNEED
+	// is emulated by prefetching the viewed range
+	if (access == WILLNEED)
+	{
+		WIN32_MEMORY_RANGE_ENTRY range = { const_cast<std::byte*>(ptr), length };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+#else
+	int advice = MADV_NORMAL;
+
+	switch (access)
+	{
+	case SEQUENTIAL:
+		advice = MADV_SEQUENTIAL;
+		break;
+	case RANDOM:
+		advice = MADV_RANDOM;
+		break;
+	case WILLNEED:
+		advice = MADV_WILLNEED;
+		break;
+	}
+
+	// madvise() needs a page aligned address, a range inside a parent
+	// view generally doesn't start at a page boundary
+	static const std::uintptr_t pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+	std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(ptr) & ~(pageSize - 1);
+	std::uintptr_t end = reinterpret_cast<std::uintptr_t>(ptr) + length;
+
+	// only a hint, failure is not an error
+	madvise(reinterpret_cast<void*>(begin), end - begin, advice);
+#endif
+}
+
+void FileView::unmap()
+{
+	if (mapping != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(mapping);
+#else
+		munmap(mapping, mappingLength);
+#endif
+	}
+
+	parent.reset();
+	buffer.clear();
+
+	mapping = nullptr;
+	mappingLength = 0;
+	ptr = nullptr;
+	length = 0;
+}
@@ -0,0 +1,180 @@
+#include <chrono>
+#include <sstream>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "fontData.h"
+#include "fontRasterizer.h"
+#include "binaryStream.h"
+#include "derivedDataCache.h"
+#include "assets.h"
+#include "trace.h"
+#include "startupReport.h"
+#include "allocationTracker.h"
+#include "jobSystem.h"
+
+
+FontData FontData::load(
+	const std::filesystem::path& path,
+	unsigned int width, unsigned int height,
+	Mode mode,
+	LoadInfo* info
+)
+{
+	TRACE_SCOPE("load font", path.string());
+	ALLOCATION_SCOPE("font load");
+
+	auto startTime = std::chrono::steady_clock::now();
+	StartupReport::AssetScope report("font", path, StartupReport::IO);
+
+	// FreeType reads the font directly from the mapping
+	FileView font = Assets::open(path, FileView::RANDOM);
+	std::uint64_t key = DerivedDataCache::key(font, params(width, height, mode));
+
+	FontData data;
+	bool cached = false;
+	unsigned int threadCount = 0;
+
+	if (std::optional<FileView> cooked = DerivedDataCache::load(key, "font"))
+	{
+		report.next(StartupReport::DECODE);
+
+		if (std::optional<FontData> cookedData = tryDeserialize(*cooked))
+		{
+			data = std::move(*cookedData);
+			cached = true;
+		}
+		else
+			DerivedDataCache::reject("font");
+	}
+
+	if (!cached)
+	{
+		report.next(StartupReport::DECODE);
+		threadCount = workerCount(0);
+		data = rasterize(font, width, height, mode, threadCount);
+
+		report.next(StartupReport::IO);
+		try { DerivedDataCache::store(key, "font", data.serialize()); }
+		catch (const std::runtime_error&) {}
+	}
+
+	if (info != nullptr)
+	{
+		info->cached = cached;
+		info->glyphCount = static_cast<unsigned int>(data.glyphs.size());
+		info->threadCount = threadCount;
+		info->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	return data;
+}
+
+FontData FontData::rasterize(
+	const FileView& font,
+	unsigned int width, unsigned int height,
+	Mode mode,
+	unsigned int threadCount
+)
+{
+	FontData data;
+	data.glyphs.resize(glyphCount);
+
+	threadCount = workerCount(threadCount);
+
+	// load first 128 characters of ASCII set, the font's missing glyph is
+	// used for characters it doesn't have; every job writes its own range
+	// of glyphs only
+	JobSystem::parallelFor(glyphCount, (glyphCount + threadCount - 1) / threadCount,
+		[&](std::size_t first, std::size_t last)
+		{
+			TRACE_SCOPE("rasterize glyphs");
+
+			FontRasterizer rasterizer(font, width, height, mode);
+
+			for (std::size_t c = first; c < last; c++)
+			{
+				std::optional<Glyph> glyph = rasterizer.rasterize(static_cast<char32_t>(c));
+				if (glyph)
+					data.glyphs[c] = std::move(*glyph);
+			}
+		}
+	);
+
+	return data;
+}
+
+std::vector<std::byte> FontData::serialize() const
+{
+	BinaryWriter writer;
+
+	writer.write<std::uint32_t>(formatVersion);
+	writer.write<std::uint64_t>(glyphs.size());
+
+	for (const Glyph& glyph : glyphs)
+	{
+		writer.write<glm::uvec2>(glyph.size);
+		writer.write<glm::ivec2>(glyph.bearing);
+		writer.write<int>(glyph.advance);
+		writer.writeVector(glyph.bitmap);
+	}
+
+	return std::move(writer.data());
+}
+
+FontData FontData::deserialize(const FileView& view)
+{
+	FontData data;
+	BinaryReader reader(view.data(), view.size());
+
+	if (reader.read<std::uint32_t>() != formatVersion)
+		throw std::runtime_error("Error: FontData::deserialize(): Unsupported format version.\n");
+
+	// size, bearing, advance and bitmap size
+	data.glyphs.resize(reader.readCount(sizeof(glm::uvec2) + sizeof(glm::ivec2) + sizeof(int) + sizeof(std::uint64_t)));
+
+	for (Glyph& glyph : data.glyphs)
+	{
+		glyph.size = reader.read<glm::uvec2>();
+		glyph.bearing = reader.read<glm::ivec2>();
+		glyph.advance = reader.read<int>();
+		glyph.bitmap = reader.readVector<std::uint8_t>();
+
+		if (glyph.bitmap.size() != std::size_t(glyph.size.x) * glyph.size.y)
+			throw std::runtime_error("Error: FontData::deserialize(): Glyph size mismatch.\n");
+	}
+
+	return data;
+}
+
+std::optional<FontData> FontData::tryDeserialize(const FileView& view)
+{
+	// a corrupt entry is rasterized again
+	try { return deserialize(view); }
+	catch (const std::runtime_error&) {}
+	catch (const std::bad_alloc&) {}
+	catch (const std::length_error&) {}
+
+	return std::nullopt;
+}
+
+unsigned int FontData::workerCount(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = JobSystem::getThreadCount();
+
+	return std::clamp(threadCount, 1u, std::max(glyphCount / minGlyphsPerThread, 1u));
+}
+
+std::string FontData::params(unsigned int width, unsigned int height, Mode mode)
+{
+	std::stringstream params;
+	params << "font;v" << formatVersion << ";ascii;" << width << "x" << height;
+
+	if (mode == SDF)
+		params << ";sdf" << sdfSpread;
+
+	return params.str();
+}
@@ -0,0 +1,161 @@
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MODULE_H
+#include FT_OUTLINE_H
+
+#include "fontRasterizer.h"
+
+
+FontRasterizer::FontRasterizer(const FileView& font, unsigned int width, unsigned int height, FontData::Mode mode)
+	: library{ nullptr }
+	, face{ nullptr }
+	, mode{ mode }
+{
+	std::stringstream errorMessage;
+	errorMessage << "Error: FontRasterizer::FontRasterizer(): ";
+
+	if (FT_Init_FreeType(&library))
+	{
+		errorMessage << "FT_Init_FreeType() failed." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	// outlines and embedded bitmaps have their own SDF renderer
+	if (mode == FontData::SDF)
+	{
+		FT_Int spread = FontData::sdfSpread;
+		FT_Property_Set(library, "sdf", "spread", &spread);
+		FT_Property_Set(library, "bsdf", "spread", &spread);
+	}
+
+	if (FT_New_Memory_Face(library,
+		reinterpret_cast<const FT_Byte*>(font.data()),
+		static_cast<FT_Long>(font.size()), 0, &face))
+	{
+		FT_Done_FreeType(library);
+		errorMessage
+			<< "FT_New_Memory_Face() failed for font "
+			<< font.getPath() << "." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	FT_Set_Pixel_Sizes(face, width, height);
+}
+
+FontRasterizer::FontRasterizer(FontRasterizer&& other) noexcept
+	: library{ other.library }
+	, face{ other.face }
+	, mode{ other.mode }
+{
+	other.library = nullptr;
+	other.face = nullptr;
+}
+
+FontRasterizer::~FontRasterizer()
+{
+	release();
+}
+
+FontRasterizer& FontRasterizer::operator=(FontRasterizer&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+
+		library = other.library;
+		face = other.face;
+		mode = other.mode;
+
+		other.library = nullptr;
+		other.face = nullptr;
+	}
+
+	return *this;
+}
+
+bool FontRasterizer::hasGlyph(char32_t codepoint) const
+{
+	return FT_Get_Char_Index(face, codepoint) != 0;
+}
+
+std::optional<FontData::Glyph> FontRasterizer::rasterize(char32_t codepoint)
+{
+	// glyph 0 is the "missing glyph" of the font
+	FT_UInt index = FT_Get_Char_Index(face, codepoint);
+	if (index == 0 && codepoint >= 128)
+		return std::nullopt;
+
+	std::stringstream errorMessage;
+	errorMessage << "Error: FontRasterizer::rasterize(): ";
+
+	// SDF glyphs are scaled when drawn, hinting for one size would distort
+	// them at all others
+	FT_Int32 flags = mode == FontData::SDF ? FT_LOAD_NO_HINTING : FT_LOAD_RENDER;
+
+	if (FT_Load_Glyph(face, index, flags))
+	{
+		errorMessage
+			<< "FT_Load_Glyph() failed for codepoint U+"
+			<< std::setw(4) << std::setfill('0') << std::hex << std::uppercase
+			<< static_cast<unsigned int>(codepoint) << "." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	FontData::Glyph glyph;
+
+	// glyphs without contours (like space) only have an advance, the SDF
+	// renderer fails for them
+	if (mode == FontData::SDF)
+	{
+		FT_GlyphSlot slot = face->glyph;
+
+		if (slot->format == FT_GLYPH_FORMAT_OUTLINE && slot->outline.n_contours == 0)
+		{
+			glyph.size = glm::uvec2(0, 0);
+			glyph.bearing = glm::ivec2(0, 0);
+			glyph.advance = static_cast<int>(slot->advance.x);
+			return glyph;
+		}
+
+		if (FT_Render_Glyph(slot, FT_RENDER_MODE_SDF))
+		{
+			errorMessage
+				<< "FT_Render_Glyph() failed for codepoint U+"
+				<< std::setw(4) << std::setfill('0') << std::hex << std::uppercase
+				<< static_cast<unsigned int>(codepoint) << "." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+	}
+
+	const FT_Bitmap& bitmap = face->glyph->bitmap;
+
+	glyph.size = glm::uvec2(bitmap.width, bitmap.rows);
+	glyph.bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+	glyph.advance = static_cast<int>(face->glyph->advance.x);
+
+	// copy row by row, FreeType rows may be padded
+	glyph.bitmap.resize(std::size_t(bitmap.width) * bitmap.rows);
+	for (unsigned int row = 0; row < bitmap.rows; row++)
+	{
+		const std::uint8_t* src = bitmap.buffer + std::size_t(row) * std::abs(bitmap.pitch);
+		std::copy(src, src + bitmap.width, glyph.bitmap.begin() + std::size_t(row) * bitmap.width);
+	}
+
+	return glyph;
+}
+
+void FontRasterizer::release()
+{
+	if (face != nullptr)
+		FT_Done_Face(face);
+	if (library != nullptr)
+		FT_Done_FreeType(library);
+
+	face = nullptr;
+	library = nullptr;
+}
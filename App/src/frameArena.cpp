@@ -0,0 +1,126 @@
+#include <algorithm>
+
+#include "frameArena.h"
+
+
+std::atomic<std::uint64_t> FrameArena::frame{ 0 };
+
+std::pmr::memory_resource* FrameArena::resource()
+{
+	return &getBuffer();
+}
+
+void* FrameArena::allocate(std::size_t size, std::size_t alignment)
+{
+	return getBuffer().allocate(size, alignment);
+}
+
+void FrameArena::nextFrame()
+{
+	frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t FrameArena::getFrame()
+{
+	return frame.load(std::memory_order_relaxed);
+}
+
+std::size_t FrameArena::getUsed()
+{
+	return getBuffer().getUsed();
+}
+
+FrameArena::Buffer& FrameArena::getBuffer()
+{
+	thread_local ThreadArena arena;
+
+	std::uint64_t now = frame.load(std::memory_order_relaxed);
+	Buffer& buffer = arena.buffers[now % 2];
+
+	// the buffer still holds the frame before the previous one (or an
+	// older one, if the thread didn't allocate for a while)
+	if (arena.frame != now)
+	{
+		arena.frame = now;
+		buffer.reset();
+	}
+
+	return buffer;
+}
+
+FrameArena::Buffer::Buffer()
+{
+	// allocated up front, so hot scopes don't allocate the first block
+	blocks.reserve(maxBlocks);
+	blocks.push_back({ std::make_unique<std::byte[]>(initialSize), initialSize });
+}
+
+void FrameArena::Buffer::reset()
+{
+	if (blocks.size() > 1)
+	{
+		std::size_t size = 0;
+		for (const Block& block : blocks)
+			size += block.size;
+
+		blocks.clear();
+		blocks.push_back({ std::make_unique<std::byte[]>(size), size });
+	}
+
+	current = 0;
+	offset = 0;
+	used = 0;
+}
+
+std::size_t FrameArena::Buffer::getUsed() const
+{
+	return used;
+}
+
+void* FrameArena::Buffer::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	while (true)
+	{
+		if (current < blocks.size())
+		{
+			Block& block = blocks[current];
+
+			std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.data.get());
+			std::uintptr_t aligned = (base + offset + alignment - 1) / alignment * alignment;
+
+			if (aligned + bytes <= base + block.size)
+			{
+				used += aligned + bytes - (base + offset);
+				offset = aligned + bytes - base;
+				return reinterpret_cast<void*>(aligned);
+			}
+
+			// the rest of the block is wasted until the buffer is reset
+			if (current + 1 < blocks.size())
+			{
+				current++;
+				offset = 0;
+				continue;
+			}
+		}
+
+		std::size_t size = std::max(
+			blocks.empty() ? initialSize : blocks.back().size * 2,
+			bytes + alignment
+		);
+
+		blocks.push_back({ std::make_unique<std::byte[]>(size), size });
+		current = blocks.size() - 1;
+		offset = 0;
+	}
+}
+
+void FrameArena::Buffer::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+	// memory is released all at once by reset()
+}
+
+bool FrameArena::Buffer::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
@@ -0,0 +1,84 @@
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "frameTimes.h"
+
+
+void FrameTimes::add(double milliseconds)
+{
+	times.push_back(milliseconds);
+}
+
+bool FrameTimes::empty() const
+{
+	return times.empty();
+}
+
+FrameTimes::Summary FrameTimes::summarize() const
+{
+	if (times.empty())
+		return { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+	std::vector<double> sorted = times;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+	for (double time : sorted)
+		total += time;
+
+	auto percentile = [&](double p)
+	{
+		return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()))];
+	};
+
+	return {
+		sorted.size(),
+		total / 1000.0,
+		sorted.front(),
+		total / sorted.size(),
+		percentile(0.5),
+		percentile(0.9),
+		percentile(0.99),
+		sorted.back()
+	};
+}
+
+void FrameTimes::print(std::ostream& stream, const std::string& name) const
+{
+	Summary summary = summarize();
+
+	stream
+		<< std::fixed << std::setprecision(3)
+		<< "Info: " << name << ": " << summary.frames << " frames in " << summary.seconds << " s, frame time "
+		<< summary.min << "/" << summary.avg << "/" << summary.p50 << "/" << summary.p90 << "/"
+		<< summary.p99 << "/" << summary.max << " ms (min/avg/p50/p90/p99/max)"
+		<< std::defaultfloat << std::endl;
+}
+
+bool FrameTimes::writeJson(const std::filesystem::path& path, const std::string& name) const
+{
+	Summary summary = summarize();
+
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	file
+		<< std::fixed << std::setprecision(4)
+		<< "{\n"
+		<< "\t\"name\": \"" << name << "\",\n"
+		<< "\t\"frames\": " << summary.frames << ",\n"
+		<< "\t\"seconds\": " << summary.seconds << ",\n"
+		<< "\t\"frame_time_ms\": {\n"
+		<< "\t\t\"min\": " << summary.min << ",\n"
+		<< "\t\t\"avg\": " << summary.avg << ",\n"
+		<< "\t\t\"p50\": " << summary.p50 << ",\n"
+		<< "\t\t\"p90\": " << summary.p90 << ",\n"
+		<< "\t\t\"p99\": " << summary.p99 << ",\n"
+		<< "\t\t\"max\": " << summary.max << "\n"
+		<< "\t}\n"
+		<< "}\n";
+
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,161 @@
+#include <algorithm>
+
+#include "frustum.h"
+#include "jobSystem.h"
+
+
+bool AABB::empty() const
+{
+	return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+void AABB::extend(const glm::vec3& point)
+{
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void AABB::extend(const AABB& other)
+{
+	if (other.empty())
+		return;
+
+	min = glm::min(min, other.min);
+	max = glm::max(max, other.max);
+}
+
+AABB AABB::transform(const glm::mat4& matrix) const
+{
+	if (empty())
+		return *this;
+
+	// the transformed center plus the extents projected onto each axis
+	// (Arvo's method), no need to transform all eight corners
+	glm::vec3 center = glm::vec3(matrix * glm::vec4((min + max) * 0.5f, 1.0f));
+	glm::vec3 extents = (max - min) * 0.5f;
+	glm::mat3 absolute = glm::mat3(matrix);
+
+	for (int i = 0; i < 3; i++)
+		absolute[i] = glm::abs(absolute[i]);
+
+	glm::vec3 newExtents = absolute * extents;
+
+	AABB box;
+	box.min = center - newExtents;
+	box.max = center + newExtents;
+	return box;
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+	// Gribb/Hartmann: the planes are sums and differences of the rows,
+	// glm matrices are stored column by column
+	const glm::mat4& m = viewProjection;
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	planes[0] = row3 + row0;	// left
+	planes[1] = row3 - row0;	// right
+	planes[2] = row3 + row1;	// bottom
+	planes[3] = row3 - row1;	// top
+	planes[4] = row3 + row2;	// near
+	planes[5] = row3 - row2;	// far
+
+	for (glm::vec4& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::intersects(const AABB& box) const
+{
+	if (box.empty())
+		return false;
+
+	for (const glm::vec4& plane : planes)
+	{
+		// the corner furthest along the plane's normal
+		glm::vec3 corner(
+			plane.x >= 0.0f ? box.max.x : box.min.x,
+			plane.y >= 0.0f ? box.max.y : box.min.y,
+			plane.z >= 0.0f ? box.max.z : box.min.z
+		);
+
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+// boxes per job when culling in parallel, fewer boxes are culled serially
+static constexpr std::size_t parallelGrainSize = 8192;
+static constexpr std::size_t maxRanges = 64;
+
+// shared by the std and the pmr overload
+template<class Boxes, class Indices>
+static std::size_t cullBoxes(const Frustum& frustum, const Boxes& boxes, Indices& visible)
+{
+	if (boxes.size() >= 2 * parallelGrainSize && JobSystem::getThreadCount() > 1)
+	{
+		// every range writes the indices of its visible boxes to its own
+		// part of the output, the parts are joined in order afterwards
+		std::size_t grainSize = std::max(parallelGrainSize, (boxes.size() + maxRanges - 1) / maxRanges);
+		std::size_t offset = visible.size();
+		std::array<std::size_t, maxRanges> counts;
+
+		visible.resize(offset + boxes.size());
+
+		JobSystem::parallelFor(boxes.size(), grainSize, [&](std::size_t first, std::size_t last)
+		{
+			std::uint32_t* output = visible.data() + offset + first;
+			std::size_t count = 0;
+
+			for (std::size_t i = first; i < last; i++)
+			{
+				if (frustum.intersects(boxes[i]))
+					output[count++] = static_cast<std::uint32_t>(i);
+			}
+
+			counts[first / grainSize] = count;
+		});
+
+		std::size_t count = 0;
+
+		for (std::size_t first = 0; first < boxes.size(); first += grainSize)
+		{
+			std::size_t rangeCount = counts[first / grainSize];
+
+			if (count != first)
+				std::copy_n(visible.data() + offset + first, rangeCount, visible.data() + offset + count);
+
+			count += rangeCount;
+		}
+
+		visible.resize(offset + count);
+		return count;
+	}
+
+	std::size_t count = 0;
+
+	for (std::size_t i = 0; i < boxes.size(); i++)
+	{
+		if (frustum.intersects(boxes[i]))
+		{
+			visible.push_back(static_cast<std::uint32_t>(i));
+			count++;
+		}
+	}
+
+	return count;
+}
+
+std::size_t Frustum::cull(const std::vector<AABB>& boxes, std::vector<std::uint32_t>& visible) const
+{
+	return cullBoxes(*this, boxes, visible);
+}
+
+std::size_t Frustum::cull(const std::pmr::vector<AABB>& boxes, std::pmr::vector<std::uint32_t>& visible) const
+{
+	return cullBoxes(*this, boxes, visible);
+}
@@ -0,0 +1,225 @@
+#include <iomanip>
+#include <algorithm>
+
+#include "glHandlePool.h"
+
+
+std::vector<GLuint> GLHandlePool::freeHandles[TYPE_COUNT];
+std::vector<GLuint> GLHandlePool::releasedHandles[TYPE_COUNT];
+std::deque<GLHandlePool::Released> GLHandlePool::fenced;
+GLHandlePool::Statistics GLHandlePool::statistics[TYPE_COUNT]{};
+
+static const char* const typeNames[GLHandlePool::TYPE_COUNT] = { "buffers", "textures", "vertex arrays" };
+
+GLuint GLHandlePool::acquire(Type type)
+{
+	GLuint handle;
+	acquire(type, 1, &handle);
+	return handle;
+}
+
+void GLHandlePool::acquire(Type type, GLsizei count, GLuint* handles)
+{
+	std::vector<GLuint>& names = freeHandles[type];
+
+	for (GLsizei i = 0; i < count; i++)
+	{
+		if (names.empty())
+			generate(type);
+
+		handles[i] = names.back();
+		names.pop_back();
+	}
+}
+
+void GLHandlePool::release(Type type, GLuint handle)
+{
+	release(type, 1, &handle);
+}
+
+void GLHandlePool::release(Type type, GLsizei count, const GLuint* handles)
+{
+	for (GLsizei i = 0; i < count; i++)
+	{
+		if (handles[i] != 0)
+			releasedHandles[type].push_back(handles[i]);
+	}
+}
+
+void GLHandlePool::collect()
+{
+	bool pending = std::any_of(std::begin(releasedHandles), std::end(releasedHandles), [](const std::vector<GLuint>& handles)
+	{
+		return !handles.empty();
+	});
+
+	if (pending)
+	{
+		Released batch;
+		batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		for (int type = 0; type < TYPE_COUNT; type++)
+			batch.handles[type].swap(releasedHandles[type]);
+
+		fenced.push_back(std::move(batch));
+	}
+
+	// fences signal in order, the first one not signaled ends the check
+	while (!fenced.empty())
+	{
+		Released& batch = fenced.front();
+
+		GLenum result = glClientWaitSync(batch.fence, 0, 0);
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+			break;
+
+		glDeleteSync(batch.fence);
+
+		for (int type = 0; type < TYPE_COUNT; type++)
+			recycle(static_cast<Type>(type), batch.handles[type]);
+
+		fenced.pop_front();
+	}
+}
+
+void GLHandlePool::clear()
+{
+	for (Released& batch : fenced)
+	{
+		glDeleteSync(batch.fence);
+
+		for (int type = 0; type < TYPE_COUNT; type++)
+			releasedHandles[type].insert(releasedHandles[type].end(), batch.handles[type].begin(), batch.handles[type].end());
+	}
+
+	fenced.clear();
+
+	for (int type = 0; type < TYPE_COUNT; type++)
+	{
+		deleteHandles(static_cast<Type>(type), static_cast<GLsizei>(freeHandles[type].size()), freeHandles[type].data());
+		deleteHandles(static_cast<Type>(type), static_cast<GLsizei>(releasedHandles[type].size()), releasedHandles[type].data());
+
+		freeHandles[type].clear();
+		releasedHandles[type].clear();
+	}
+}
+
+GLHandlePool::Statistics GLHandlePool::getStatistics(Type type)
+{
+	return statistics[type];
+}
+
+void GLHandlePool::printStatistics(std::ostream& stream)
+{
+	for (int type = 0; type < TYPE_COUNT; type++)
+	{
+		const Statistics& stats = statistics[type];
+
+		stream
+			<< "Info: GLHandlePool: " << std::left << std::setw(14) << typeNames[type] << std::right
+			<< stats.generated << " generated in " << stats.batches << " batches, "
+			<< stats.recycled << " recycled, " << stats.deleted << " deleted" << std::endl;
+	}
+}
+
+void GLHandlePool::generate(Type type)
+{
+	std::vector<GLuint>& names = freeHandles[type];
+	std::size_t first = names.size();
+	names.resize(first + batchSize);
+
+	switch (type)
+	{
+	case BUFFER:
+		glGenBuffers(batchSize, names.data() + first);
+		break;
+	case TEXTURE:
+		glGenTextures(batchSize, names.data() + first);
+		break;
+	case VERTEX_ARRAY:
+		glGenVertexArrays(batchSize, names.data() + first);
+		break;
+	default:
+		break;
+	}
+
+	statistics[type].generated += batchSize;
+	statistics[type].batches++;
+}
+
+void GLHandlePool::recycle(Type type, std::vector<GLuint>& handles)
+{
+	if (handles.empty())
+		return;
+
+	// textures keep their target, they can't be reused for another one
+	std::size_t keep = type == TEXTURE ? 0 : std::min(handles.size(), maxFree - std::min(maxFree, freeHandles[type].size()));
+	std::size_t drop = handles.size() - keep;
+
+	deleteHandles(type, static_cast<GLsizei>(drop), handles.data() + keep);
+	handles.resize(keep);
+
+	if (type == BUFFER)
+	{
+		// the storage isn't needed until the name is specified again
+		for (GLuint buffer : handles)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	else if (type == VERTEX_ARRAY)
+	{
+		static const GLint maxAttributes = []()
+		{
+			GLint count = 0;
+			glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &count);
+			return count;
+		}();
+
+		GLint previous = 0;
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+
+		// attribute pointers are set again by whoever gets the name, only
+		// enabled attributes and the index buffer would leak through
+		for (GLuint vertexArray : handles)
+		{
+			glBindVertexArray(vertexArray);
+
+			for (GLint i = 0; i < maxAttributes; i++)
+				glDisableVertexAttribArray(i);
+
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		}
+
+		glBindVertexArray(previous);
+	}
+
+	freeHandles[type].insert(freeHandles[type].end(), handles.begin(), handles.end());
+	statistics[type].recycled += handles.size();
+}
+
+void GLHandlePool::deleteHandles(Type type, GLsizei count, const GLuint* handles)
+{
+	if (count == 0)
+		return;
+
+	switch (type)
+	{
+	case BUFFER:
+		glDeleteBuffers(count, handles);
+		break;
+	case TEXTURE:
+		glDeleteTextures(count, handles);
+		break;
+	case VERTEX_ARRAY:
+		glDeleteVertexArrays(count, handles);
+		break;
+	default:
+		break;
+	}
+
+	statistics[type].deleted += count;
+}
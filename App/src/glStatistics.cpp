@@ -0,0 +1,377 @@
+#include <fstream>
+#include <GL/glew.h>
+
+#include "glStatistics.h"
+
+
+bool GLStatistics::installed = false;
+GLStatistics::Counters GLStatistics::counters = {};
+GLStatistics::Counters GLStatistics::lastFrame = {};
+std::array<GLStatistics::Counters, GLStatistics::historySize> GLStatistics::history = {};
+std::uint64_t GLStatistics::frameCount = 0;
+
+// GLEW entry points that only count calls, by the counter they count into
+#define GL_COUNTED_FUNCTIONS(X) \
+	X(DrawElementsBaseVertex, DRAW_CALLS) \
+	X(DrawElementsInstanced, DRAW_CALLS) \
+	X(DrawElementsInstancedBaseVertex, DRAW_CALLS) \
+	X(DrawArraysInstanced, DRAW_CALLS) \
+	X(DrawRangeElements, DRAW_CALLS) \
+	X(MultiDrawElementsIndirect, DRAW_CALLS) \
+	X(BindBuffer, STATE_CHANGES) \
+	X(BindBufferBase, STATE_CHANGES) \
+	X(BindVertexArray, STATE_CHANGES) \
+	X(BindFramebuffer, STATE_CHANGES) \
+	X(UseProgram, STATE_CHANGES) \
+	X(ActiveTexture, STATE_CHANGES) \
+	X(GetUniformLocation, UNIFORM_LOCATIONS) \
+	X(Uniform1f, UNIFORM_UPDATES) \
+	X(Uniform2f, UNIFORM_UPDATES) \
+	X(Uniform3f, UNIFORM_UPDATES) \
+	X(Uniform4f, UNIFORM_UPDATES) \
+	X(Uniform1i, UNIFORM_UPDATES) \
+	X(Uniform2i, UNIFORM_UPDATES) \
+	X(Uniform3i, UNIFORM_UPDATES) \
+	X(Uniform4i, UNIFORM_UPDATES) \
+	X(Uniform1ui, UNIFORM_UPDATES) \
+	X(Uniform2ui, UNIFORM_UPDATES) \
+	X(Uniform3ui, UNIFORM_UPDATES) \
+	X(Uniform4ui, UNIFORM_UPDATES) \
+	X(Uniform1fv, UNIFORM_UPDATES) \
+	X(Uniform2fv, UNIFORM_UPDATES) \
+	X(Uniform3fv, UNIFORM_UPDATES) \
+	X(Uniform4fv, UNIFORM_UPDATES) \
+	X(Uniform1iv, UNIFORM_UPDATES) \
+	X(Uniform2iv, UNIFORM_UPDATES) \
+	X(Uniform3iv, UNIFORM_UPDATES) \
+	X(Uniform4iv, UNIFORM_UPDATES) \
+	X(Uniform1uiv, UNIFORM_UPDATES) \
+	X(Uniform2uiv, UNIFORM_UPDATES) \
+	X(Uniform3uiv, UNIFORM_UPDATES) \
+	X(Uniform4uiv, UNIFORM_UPDATES) \
+	X(UniformMatrix2fv, UNIFORM_UPDATES) \
+	X(UniformMatrix3fv, UNIFORM_UPDATES) \
+	X(UniformMatrix4fv, UNIFORM_UPDATES) \
+	X(UniformMatrix2x3fv, UNIFORM_UPDATES) \
+	X(UniformMatrix3x2fv, UNIFORM_UPDATES) \
+	X(UniformMatrix2x4fv, UNIFORM_UPDATES) \
+	X(UniformMatrix4x2fv, UNIFORM_UPDATES) \
+	X(UniformMatrix3x4fv, UNIFORM_UPDATES) \
+	X(UniformMatrix4x3fv, UNIFORM_UPDATES)
+
+namespace
+{
+	// one instantiation per wrapped function (told apart by the tag), which
+	// forwards to the original entry point; function pointers can't be
+	// template arguments, GLEW's may be imported from a DLL
+	template<typename Tag, typename Function>
+	struct Counted;
+
+	template<typename Tag, typename Result, typename... Arguments>
+	struct Counted<Tag, Result (GLAPIENTRY*)(Arguments...)>
+	{
+		using Function = Result (GLAPIENTRY*)(Arguments...);
+
+		static inline Function original = nullptr;
+		static inline GLStatistics::Counter counter = GLStatistics::DRAW_CALLS;
+
+		static Result GLAPIENTRY call(Arguments... arguments)
+		{
+			GLStatistics::count(counter);
+			return original(arguments...);
+		}
+
+		static void install(Function& pointer, GLStatistics::Counter counter)
+		{
+			// entry points the driver doesn't provide stay null
+			if (pointer == nullptr || pointer == call)
+				return;
+
+			original = pointer;
+			Counted::counter = counter;
+			pointer = call;
+		}
+
+		static void uninstall(Function& pointer)
+		{
+			if (pointer == call)
+				pointer = original;
+		}
+	};
+
+#define GL_COUNTED_TAG(function, counter) struct function##Tag;
+	GL_COUNTED_FUNCTIONS(GL_COUNTED_TAG)
+#undef GL_COUNTED_TAG
+
+	// uploads count bytes as well
+	PFNGLBUFFERDATAPROC originalBufferData = nullptr;
+	PFNGLBUFFERSUBDATAPROC originalBufferSubData = nullptr;
+	PFNGLBUFFERSTORAGEPROC originalBufferStorage = nullptr;
+	PFNGLTEXIMAGE3DPROC originalTexImage3D = nullptr;
+	PFNGLTEXSUBIMAGE3DPROC originalTexSubImage3D = nullptr;
+
+	void GLAPIENTRY countedBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		// allocating without data isn't an upload
+		if (data != nullptr)
+		{
+			GLStatistics::count(GLStatistics::BUFFER_UPLOADS);
+			GLStatistics::count(GLStatistics::BUFFER_BYTES, size);
+		}
+
+		originalBufferData(target, size, data, usage);
+	}
+
+	void GLAPIENTRY countedBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		GLStatistics::count(GLStatistics::BUFFER_UPLOADS);
+		GLStatistics::count(GLStatistics::BUFFER_BYTES, size);
+
+		originalBufferSubData(target, offset, size, data);
+	}
+
+	void GLAPIENTRY countedBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+	{
+		if (data != nullptr)
+		{
+			GLStatistics::count(GLStatistics::BUFFER_UPLOADS);
+			GLStatistics::count(GLStatistics::BUFFER_BYTES, size);
+		}
+
+		originalBufferStorage(target, size, data, flags);
+	}
+
+	void GLAPIENTRY countedTexImage3D(
+		GLenum target, GLint level, GLint internalFormat,
+		GLsizei width, GLsizei height, GLsizei depth, GLint border,
+		GLenum format, GLenum type, const void* pixels
+	)
+	{
+		if (pixels != nullptr)
+		{
+			GLStatistics::count(GLStatistics::TEXTURE_UPLOADS);
+			GLStatistics::count(GLStatistics::TEXTURE_BYTES,
+				static_cast<std::uint64_t>(width) * height * depth * GLStatistics::pixelSize(format, type));
+		}
+
+		originalTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+	}
+
+	void GLAPIENTRY countedTexSubImage3D(
+		GLenum target, GLint level,
+		GLint xOffset, GLint yOffset, GLint zOffset,
+		GLsizei width, GLsizei height, GLsizei depth,
+		GLenum format, GLenum type, const void* pixels
+	)
+	{
+		GLStatistics::count(GLStatistics::TEXTURE_UPLOADS);
+		GLStatistics::count(GLStatistics::TEXTURE_BYTES,
+			static_cast<std::uint64_t>(width) * height * depth * GLStatistics::pixelSize(format, type));
+
+		originalTexSubImage3D(target, level, xOffset, yOffset, zOffset, width, height, depth, format, type, pixels);
+	}
+
+	template<typename Function>
+	void replace(Function& pointer, Function& original, Function counted)
+	{
+		if (pointer == nullptr || pointer == counted)
+			return;
+
+		original = pointer;
+		pointer = counted;
+	}
+
+	template<typename Function>
+	void restore(Function& pointer, Function original, Function counted)
+	{
+		if (pointer == counted)
+			pointer = original;
+	}
+}
+
+void GLStatistics::install()
+{
+	if (installed)
+		return;
+
+#define GL_COUNTED_INSTALL(function, counter) \
+	Counted<function##Tag, decltype(__glew##function)>::install(__glew##function, counter);
+	GL_COUNTED_FUNCTIONS(GL_COUNTED_INSTALL)
+#undef GL_COUNTED_INSTALL
+
+	replace(__glewBufferData, originalBufferData, countedBufferData);
+	replace(__glewBufferSubData, originalBufferSubData, countedBufferSubData);
+	replace(__glewBufferStorage, originalBufferStorage, countedBufferStorage);
+	replace(__glewTexImage3D, originalTexImage3D, countedTexImage3D);
+	replace(__glewTexSubImage3D, originalTexSubImage3D, countedTexSubImage3D);
+
+	counters = {};
+	installed = true;
+}
+
+void GLStatistics::uninstall()
+{
+	if (!installed)
+		return;
+
+#define GL_COUNTED_UNINSTALL(function, counter) \
+	Counted<function##Tag, decltype(__glew##function)>::uninstall(__glew##function);
+	GL_COUNTED_FUNCTIONS(GL_COUNTED_UNINSTALL)
+#undef GL_COUNTED_UNINSTALL
+
+	restore(__glewBufferData, originalBufferData, countedBufferData);
+	restore(__glewBufferSubData, originalBufferSubData, countedBufferSubData);
+	restore(__glewBufferStorage, originalBufferStorage, countedBufferStorage);
+	restore(__glewTexImage3D, originalTexImage3D, countedTexImage3D);
+	restore(__glewTexSubImage3D, originalTexSubImage3D, countedTexSubImage3D);
+
+	installed = false;
+}
+
+bool GLStatistics::isInstalled()
+{
+	return installed;
+}
+
+void GLStatistics::count(Counter counter, std::uint64_t amount)
+{
+	if (installed)
+		counters[counter] += amount;
+}
+
+void GLStatistics::endFrame()
+{
+	if (!installed)
+		return;
+
+	lastFrame = counters;
+	history[frameCount % historySize] = counters;
+	frameCount++;
+
+	counters = {};
+}
+
+const GLStatistics::Counters& GLStatistics::getLastFrame()
+{
+	return lastFrame;
+}
+
+const char* GLStatistics::toString(Counter counter)
+{
+	switch (counter)
+	{
+	case DRAW_CALLS:
+		return "draw_calls";
+	case STATE_CHANGES:
+		return "state_changes";
+	case BUFFER_UPLOADS:
+		return "buffer_uploads";
+	case BUFFER_BYTES:
+		return "buffer_bytes";
+	case TEXTURE_UPLOADS:
+		return "texture_uploads";
+	case TEXTURE_BYTES:
+		return "texture_bytes";
+	case UNIFORM_UPDATES:
+		return "uniform_updates";
+	case UNIFORM_LOCATIONS:
+		return "uniform_locations";
+	default:
+		return "unknown";
+	}
+}
+
+void GLStatistics::writeJson(std::ostream& stream)
+{
+	// oldest frame first
+	std::uint64_t first = frameCount > historySize ? frameCount - historySize : 0;
+
+	stream << "{\"frames\":[";
+
+	for (std::uint64_t frame = first; frame < frameCount; frame++)
+	{
+		const Counters& frameCounters = history[frame % historySize];
+
+		stream << (frame == first ? "\n" : ",\n") << "{\"frame\":" << frame;
+		for (int counter = 0; counter < COUNTER_COUNT; counter++)
+			stream << ",\"" << toString(static_cast<Counter>(counter)) << "\":" << frameCounters[counter];
+		stream << "}";
+	}
+
+	stream << "\n]}\n";
+}
+
+bool GLStatistics::dump(const std::filesystem::path& path)
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	writeJson(file);
+	return static_cast<bool>(file);
+}
+
+std::uint64_t GLStatistics::pixelSize(unsigned int format, unsigned int type)
+{
+	// packed types hold all components of a pixel
+	switch (type)
+	{
+	case GL_UNSIGNED_BYTE_3_3_2:
+	case GL_UNSIGNED_BYTE_2_3_3_REV:
+		return 1;
+	case GL_UNSIGNED_SHORT_5_6_5:
+	case GL_UNSIGNED_SHORT_5_6_5_REV:
+	case GL_UNSIGNED_SHORT_4_4_4_4:
+	case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+	case GL_UNSIGNED_SHORT_5_5_5_1:
+	case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+		return 2;
+	case GL_UNSIGNED_INT_8_8_8_8:
+	case GL_UNSIGNED_INT_8_8_8_8_REV:
+	case GL_UNSIGNED_INT_10_10_10_2:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_24_8:
+	case GL_UNSIGNED_INT_10F_11F_11F_REV:
+	case GL_UNSIGNED_INT_5_9_9_9_REV:
+		return 4;
+	}
+
+	std::uint64_t components;
+	switch (format)
+	{
+	case GL_RG:
+	case GL_RG_INTEGER:
+	case GL_DEPTH_STENCIL:
+		components = 2;
+		break;
+	case GL_RGB:
+	case GL_BGR:
+	case GL_RGB_INTEGER:
+	case GL_BGR_INTEGER:
+		components = 3;
+		break;
+	case GL_RGBA:
+	case GL_BGRA:
+	case GL_RGBA_INTEGER:
+	case GL_BGRA_INTEGER:
+		components = 4;
+		break;
+	default:
+		components = 1;
+		break;
+	}
+
+	switch (type)
+	{
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+	case GL_HALF_FLOAT:
+		return components * 2;
+	case GL_INT:
+	case GL_UNSIGNED_INT:
+	case GL_FLOAT:
+		return components * 4;
+	default:
+		return components;
+	}
+}
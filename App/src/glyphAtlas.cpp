@@ -0,0 +1,334 @@
+#include <utility>
+#include <algorithm>
+
+#include "glyphAtlas.h"
+#include "glHandlePool.h"
+
+
+GlyphAtlas::GlyphAtlas()
+	: texture{ 0 }
+	, pageSize{ glm::uvec2(0, 0) }
+	, frame{ 0 }
+	, evictionCount{ 0 }
+{
+
+}
+
+GlyphAtlas::GlyphAtlas(glm::uvec2 pageSize, GLsizei pageCount)
+	: GlyphAtlas(pageSize, pageCount, FontData{})
+{
+
+}
+
+GlyphAtlas::GlyphAtlas(glm::uvec2 pageSize, GLsizei pageCount, const FontData& font)
+	: texture{ 0 }
+	, pageSize{ pageSize }
+	, pages(pageCount)
+	, blocks(codepointCount / blockSize)
+	, frame{ 0 }
+	, evictionCount{ 0 }
+{
+	// cleared pages, so the padding around glyphs is empty
+	std::size_t pageBytes = static_cast<std::size_t>(pageSize.x) * pageSize.y;
+	std::vector<std::uint8_t> pixels(pageBytes * pageCount, 0);
+
+	// the preloaded glyphs are copied into the pages before the upload
+	for (char32_t c = 32; c < 127 && c < font.glyphs.size(); c++)
+	{
+		const FontData::Glyph& glyph = font.glyphs[c];
+
+		glm::uvec2 position;
+		const Glyph* placed = place(c, glyph, position);
+		if (placed == nullptr)
+			break;
+
+		std::uint8_t* page = pixels.data() + placed->page * pageBytes;
+		for (unsigned int row = 0; row < glyph.size.y; row++)
+		{
+			std::copy_n(
+				glyph.bitmap.data() + static_cast<std::size_t>(row) * glyph.size.x,
+				glyph.size.x,
+				page + static_cast<std::size_t>(position.y + row) * pageSize.x + position.x
+			);
+		}
+	}
+
+	// texture begin
+	texture = GLHandlePool::acquire(GLHandlePool::TEXTURE);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+	// glyph rows are not aligned to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage3D(
+		GL_TEXTURE_2D_ARRAY,
+		0,
+		GL_R8,
+		pageSize.x,
+		pageSize.y,
+		pageCount,
+		0,
+		GL_RED,
+		GL_UNSIGNED_BYTE,
+		pixels.data()
+	);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	// texture end
+
+	gpuMemory = GPUMemory::Allocation(GPUMemory::GLYPHS, pixels.size());
+}
+
+GlyphAtlas::GlyphAtlas(GlyphAtlas&& other) noexcept
+	: texture{ other.texture }
+	, pageSize{ other.pageSize }
+	, gpuMemory{ std::move(other.gpuMemory) }
+	, pages{ std::move(other.pages) }
+	, blocks{ std::move(other.blocks) }
+	, frame{ other.frame }
+	, evictionCount{ other.evictionCount }
+{
+	other.texture = 0;
+	other.pageSize = glm::uvec2(0, 0);
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+	deleteGLObjects();
+}
+
+GlyphAtlas& GlyphAtlas::operator=(GlyphAtlas&& other) noexcept
+{
+	if (this != &other)
+	{
+		deleteGLObjects();
+
+		texture = other.texture;
+		pageSize = other.pageSize;
+		gpuMemory = std::move(other.gpuMemory);
+		pages = std::move(other.pages);
+		blocks = std::move(other.blocks);
+		frame = other.frame;
+		evictionCount = other.evictionCount;
+
+		other.texture = 0;
+		other.pageSize = glm::uvec2(0, 0);
+	}
+
+	return *this;
+}
+
+GlyphAtlas::State GlyphAtlas::lookup(char32_t codepoint, const Glyph*& glyph)
+{
+	glyph = nullptr;
+
+	if (codepoint >= codepointCount)
+		return MISSING;
+
+	// blocks that were never used don't have to be allocated for a lookup
+	const std::unique_ptr<Block>& block = blocks[codepoint / blockSize];
+	if (!block)
+		return UNKNOWN;
+
+	Entry& entry = (*block)[codepoint % blockSize];
+
+	if (entry.state == RESIDENT)
+	{
+		glyph = &entry.glyph;
+		pages[entry.glyph.page].lastUse = frame;
+	}
+
+	return entry.state;
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::insert(char32_t codepoint, const FontData::Glyph& glyph)
+{
+	glm::uvec2 position;
+	const Glyph* inserted = place(codepoint, glyph, position);
+
+	if (inserted != nullptr && glyph.size.x > 0 && glyph.size.y > 0)
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			0,
+			position.x, position.y, inserted->page,
+			glyph.size.x, glyph.size.y, 1,
+			GL_RED,
+			GL_UNSIGNED_BYTE,
+			glyph.bitmap.data()
+		);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	return inserted;
+}
+
+void GlyphAtlas::markMissing(char32_t codepoint)
+{
+	if (codepoint < codepointCount)
+		getEntry(codepoint).state = MISSING;
+}
+
+void GlyphAtlas::evictPage()
+{
+	if (pages.empty())
+		return;
+
+	auto page = std::min_element(pages.begin(), pages.end(), [](const Page& a, const Page& b)
+	{
+		return a.lastUse < b.lastUse;
+	});
+
+	for (char32_t codepoint : page->codepoints)
+		getEntry(codepoint).state = UNKNOWN;
+
+	page->codepoints.clear();
+	page->shelves.clear();
+
+	// the padding around glyphs inserted later has to be empty again
+	std::vector<std::uint8_t> pixels(static_cast<std::size_t>(pageSize.x) * pageSize.y, 0);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexSubImage3D(
+		GL_TEXTURE_2D_ARRAY,
+		0,
+		0, 0, static_cast<GLint>(page - pages.begin()),
+		pageSize.x, pageSize.y, 1,
+		GL_RED,
+		GL_UNSIGNED_BYTE,
+		pixels.data()
+	);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	evictionCount++;
+}
+
+void GlyphAtlas::markUsed(GLuint page)
+{
+	if (page < pages.size())
+		pages[page].lastUse = frame;
+}
+
+void GlyphAtlas::nextFrame()
+{
+	frame++;
+}
+
+GLuint GlyphAtlas::getTexture() const
+{
+	return texture;
+}
+
+glm::uvec2 GlyphAtlas::getPageSize() const
+{
+	return pageSize;
+}
+
+GLsizei GlyphAtlas::getPageCount() const
+{
+	return static_cast<GLsizei>(pages.size());
+}
+
+unsigned int GlyphAtlas::getEvictionCount() const
+{
+	return evictionCount;
+}
+
+GlyphAtlas::Entry& GlyphAtlas::getEntry(char32_t codepoint)
+{
+	std::unique_ptr<Block>& block = blocks[codepoint / blockSize];
+
+	if (!block)
+	{
+		block = std::make_unique<Block>();
+		for (Entry& entry : *block)
+			entry.state = UNKNOWN;
+	}
+
+	return (*block)[codepoint % blockSize];
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::place(char32_t codepoint, const FontData::Glyph& glyph, glm::uvec2& position)
+{
+	if (codepoint >= codepointCount)
+		return nullptr;
+
+	// the most recently used pages are tried first, so glyphs used together
+	// tend to end up on the same page and are evicted together
+	std::vector<GLuint> order(pages.size());
+	for (GLuint i = 0; i < order.size(); i++)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&](GLuint a, GLuint b)
+	{
+		return pages[a].lastUse > pages[b].lastUse;
+	});
+
+	for (GLuint page : order)
+	{
+		if (!pack(pages[page].shelves, pageSize, glyph.size, position))
+			continue;
+
+		pages[page].codepoints.push_back(codepoint);
+		pages[page].lastUse = frame;
+
+		Entry& entry = getEntry(codepoint);
+		entry.glyph = {
+			glyph.size,
+			glyph.bearing,
+			glyph.advance,
+			glm::vec2(position) / glm::vec2(pageSize),
+			glm::vec2(position + glyph.size) / glm::vec2(pageSize),
+			page
+		};
+		entry.state = RESIDENT;
+
+		return &entry.glyph;
+	}
+
+	return nullptr;
+}
+
+bool GlyphAtlas::pack(
+	std::vector<Shelf>& shelves,
+	glm::uvec2 pageSize,
+	glm::uvec2 glyphSize,
+	glm::uvec2& position
+)
+{
+	glm::uvec2 paddedSize = glyphSize + padding;
+
+	// first shelf that is high enough and has space left
+	for (Shelf& shelf : shelves)
+	{
+		if (paddedSize.y <= shelf.height && shelf.width + paddedSize.x + padding <= pageSize.x)
+		{
+			position = glm::uvec2(shelf.width + padding, shelf.y + padding);
+			shelf.width += paddedSize.x;
+			return true;
+		}
+	}
+
+	// otherwise a new shelf is opened below the last one
+	unsigned int y = shelves.empty() ? 0 : shelves.back().y + shelves.back().height;
+
+	if (paddedSize.x + padding > pageSize.x || y + paddedSize.y + padding > pageSize.y)
+		return false;
+
+	shelves.push_back({ y, paddedSize.y, paddedSize.x });
+	position = glm::uvec2(padding, y + padding);
+
+	return true;
+}
+
+void GlyphAtlas::deleteGLObjects()
+{
+	GLHandlePool::release(GLHandlePool::TEXTURE, texture);
+	gpuMemory = GPUMemory::Allocation();
+}
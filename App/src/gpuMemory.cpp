@@ -0,0 +1,199 @@
+#include <limits>
+#include <iomanip>
+#include <GL/glew.h>
+
+#include "gpuMemory.h"
+
+
+std::atomic<std::uint64_t> GPUMemory::usage[CATEGORY_COUNT]{};
+
+std::uint64_t GPUMemory::budget = 0;
+std::uint64_t GPUMemory::derivedBudget = 0;
+GPUMemory::Clock::time_point GPUMemory::derivedTime;
+bool GPUMemory::derived = false;
+
+static const char* const categoryNames[GPUMemory::CATEGORY_COUNT] = { "geometry", "textures", "glyphs", "render targets" };
+
+GPUMemory::Allocation::Allocation()
+	: category{ GEOMETRY }
+	, size{ 0 }
+{
+
+}
+
+GPUMemory::Allocation::Allocation(Category category, std::uint64_t size)
+	: category{ category }
+	, size{ size }
+{
+	usage[category] += size;
+}
+
+GPUMemory::Allocation::Allocation(Allocation&& other) noexcept
+	: category{ other.category }
+	, size{ other.size }
+{
+	other.size = 0;
+}
+
+GPUMemory::Allocation::~Allocation()
+{
+	usage[category] -= size;
+}
+
+GPUMemory::Allocation& GPUMemory::Allocation::operator=(Allocation&& other) noexcept
+{
+	if (this != &other)
+	{
+		usage[category] -= size;
+
+		category = other.category;
+		size = other.size;
+
+		other.size = 0;
+	}
+
+	return *this;
+}
+
+void GPUMemory::Allocation::resize(std::uint64_t size)
+{
+	usage[category] += size;
+	usage[category] -= this->size;
+	this->size = size;
+}
+
+std::uint64_t GPUMemory::Allocation::getSize() const
+{
+	return size;
+}
+
+std::uint64_t GPUMemory::getUsage(Category category)
+{
+	return usage[category];
+}
+
+std::uint64_t GPUMemory::getUsage()
+{
+	std::uint64_t sum = 0;
+	for (const std::atomic<std::uint64_t>& categoryUsage : usage)
+		sum += categoryUsage;
+	return sum;
+}
+
+GPUMemory::DeviceInfo GPUMemory::queryDevice()
+{
+	DeviceInfo info{};
+
+	// both extensions report kilobytes
+	if (GLEW_NVX_gpu_memory_info)
+	{
+		GLint dedicated = 0;
+		GLint available = 0;
+		GLint evicted = 0;
+		glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated);
+		glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+		glGetIntegerv(GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX, &evicted);
+
+		info.available = true;
+		info.dedicated = static_cast<std::uint64_t>(dedicated) * 1024;
+		info.free = static_cast<std::uint64_t>(available) * 1024;
+		info.evicted = static_cast<std::uint64_t>(evicted) * 1024;
+	}
+	else if (GLEW_ATI_meminfo)
+	{
+		// total free, largest free block, total and largest free auxiliary
+		GLint textureFree[4] = {};
+		glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, textureFree);
+
+		info.available = true;
+		info.free = static_cast<std::uint64_t>(textureFree[0]) * 1024;
+	}
+
+	return info;
+}
+
+void GPUMemory::setBudget(std::uint64_t budget)
+{
+	GPUMemory::budget = budget;
+	derived = false;
+}
+
+std::uint64_t GPUMemory::getBudget()
+{
+	if (budget != 0)
+		return budget;
+
+	Clock::time_point now = Clock::now();
+	if (derived && std::chrono::duration<double>(now - derivedTime).count() < refreshInterval)
+		return derivedBudget;
+
+	DeviceInfo info = queryDevice();
+
+	if (info.dedicated != 0)
+		derivedBudget = static_cast<std::uint64_t>(info.dedicated * deviceShare);
+	else if (info.available)
+		derivedBudget = static_cast<std::uint64_t>((getUsage() + info.free) * deviceShare);
+	else
+		derivedBudget = std::numeric_limits<std::uint64_t>::max();
+
+	derivedTime = now;
+	derived = true;
+
+	return derivedBudget;
+}
+
+std::int64_t GPUMemory::getHeadroom()
+{
+	std::uint64_t currentBudget = getBudget();
+	std::uint64_t currentUsage = getUsage();
+
+	if (currentBudget == std::numeric_limits<std::uint64_t>::max())
+		return std::numeric_limits<std::int64_t>::max();
+
+	return static_cast<std::int64_t>(currentBudget) - static_cast<std::int64_t>(currentUsage);
+}
+
+bool GPUMemory::fits(std::uint64_t size)
+{
+	std::int64_t headroom = getHeadroom();
+	return headroom >= 0 && size <= static_cast<std::uint64_t>(headroom);
+}
+
+const char* GPUMemory::toString(Category category)
+{
+	return categoryNames[category];
+}
+
+void GPUMemory::printStatistics(std::ostream& stream)
+{
+	auto mib = [](std::uint64_t bytes) { return bytes / (1024.0 * 1024.0); };
+
+	stream << std::fixed << std::setprecision(2);
+
+	for (int category = 0; category < CATEGORY_COUNT; category++)
+	{
+		stream
+			<< "Info: GPUMemory: " << std::left << std::setw(16) << categoryNames[category] << std::right
+			<< std::setw(10) << mib(usage[category]) << " MiB" << std::endl;
+	}
+
+	stream << "Info: GPUMemory: " << std::left << std::setw(16) << "total" << std::right << std::setw(10) << mib(getUsage()) << " MiB";
+
+	std::uint64_t currentBudget = getBudget();
+	if (currentBudget != std::numeric_limits<std::uint64_t>::max())
+		stream << " of " << mib(currentBudget) << " MiB budget";
+	stream << std::endl;
+
+	DeviceInfo info = queryDevice();
+	if (info.available)
+	{
+		stream << "Info: GPUMemory: device " << mib(info.free) << " MiB free";
+		if (info.dedicated != 0)
+			stream << " of " << mib(info.dedicated) << " MiB dedicated, " << mib(info.evicted) << " MiB evicted";
+		stream << std::endl;
+	}
+	else
+		stream << "Info: GPUMemory: device doesn't report its memory" << std::endl;
+
+	stream << std::defaultfloat;
+}
@@ -1,6 +1,7 @@
 #include <sstream>
 
 #include "image.h"
+#include "assets.h"
 
 
 int Image::instanceCount = 0;
@@ -144,9 +145,24 @@ bool Image::readFile(const std::filesystem::path& path)
 	ilDeleteImage(image);
 
 	image = ilGenImage();
+
+	// decode directly from the mapped file instead of letting DevIL
+	// read it through its own buffered file I/O
+	FileView file;
+	try { file = Assets::open(path, FileView::SEQUENTIAL); }
+	catch (const std::runtime_error&)
+	{
+		error = IL_COULD_NOT_OPEN_FILE;
+		return evaluateError("Error: Image::readFile(): ");
+	}
+
+	// some formats (.tga for example) can't be detected from their header,
+	// IL_TYPE_UNKNOWN lets DevIL guess the type from the data otherwise
+	ILenum type = ilTypeFromExt(path.string().c_str());
+
 	ilBindImage(image);
 	ilGetError();
-	ilLoadImage(path.string().c_str());
+	ilLoadL(type, file.data(), static_cast<ILuint>(file.size()));
 	error = ilGetError();
 	ilBindImage(0);
 
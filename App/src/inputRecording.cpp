@@ -0,0 +1,129 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "inputRecording.h"
+#include "binaryStream.h"
+#include "compression.h"
+#include "fileView.h"
+
+
+std::size_t InputRecording::getFrameCount() const
+{
+	return deltaTimes.size();
+}
+
+InputRecording InputRecording::load(const std::filesystem::path& path)
+{
+	std::stringstream errorMessage;
+	errorMessage << "Error: InputRecording::load(): ";
+
+	if (!std::filesystem::exists(path))
+	{
+		errorMessage << "File " << path.string() << " doesn't exist." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	FileView view(path, FileView::SEQUENTIAL);
+	BinaryReader reader(view.data(), view.size());
+
+	std::uint32_t fileMagic = reader.read<std::uint32_t>();
+	std::uint32_t fileVersion = reader.read<std::uint32_t>();
+	if (fileMagic != magic || fileVersion != formatVersion)
+	{
+		errorMessage << path.string() << " isn't an input recording of version " << formatVersion << "." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	std::vector<std::byte> data(reader.read<std::uint64_t>());
+	std::size_t headerSize = 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+	Compression::decompress(
+		Compression::ZSTD,
+		view.data() + headerSize, view.size() - headerSize,
+		data.data(), data.size()
+	);
+
+	return deserialize(data.data(), data.size());
+}
+
+void InputRecording::save(const std::filesystem::path& path) const
+{
+	std::vector<std::byte> data = serialize();
+	std::vector<std::byte> compressed = Compression::compress(Compression::ZSTD, data.data(), data.size());
+
+	BinaryWriter header;
+	header.write<std::uint32_t>(magic);
+	header.write<std::uint32_t>(formatVersion);
+	header.write<std::uint64_t>(data.size());
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(header.data().data()), header.data().size());
+	file.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+
+	if (!file)
+	{
+		std::stringstream errorMessage;
+		errorMessage << "Error: InputRecording::save(): Couldn't write " << path.string() << "." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+}
+
+std::vector<std::byte> InputRecording::serialize() const
+{
+	BinaryWriter writer;
+
+	writer.writeVector(deltaTimes);
+
+	// field by field, keys don't need the doubles
+	writer.write<std::uint64_t>(events.size());
+	for (const Event& event : events)
+	{
+		writer.write<std::uint32_t>(event.frame);
+		writer.write<std::uint8_t>(event.type);
+
+		if (event.type == KEY)
+		{
+			writer.write<std::int16_t>(static_cast<std::int16_t>(event.x));
+			writer.write<std::uint8_t>(static_cast<std::uint8_t>(event.y));
+		}
+		else
+		{
+			writer.write<double>(event.x);
+			writer.write<double>(event.y);
+		}
+	}
+
+	return std::move(writer.data());
+}
+
+InputRecording InputRecording::deserialize(const std::byte* data, std::size_t size)
+{
+	InputRecording recording;
+	BinaryReader reader(data, size);
+
+	recording.deltaTimes = reader.readVector<double>();
+
+	// frame, type and the smallest payload (a key)
+	recording.events.resize(reader.readCount(sizeof(std::uint32_t) + sizeof(std::uint8_t) + sizeof(std::int16_t) + sizeof(std::uint8_t)));
+	for (Event& event : recording.events)
+	{
+		event.frame = reader.read<std::uint32_t>();
+		event.type = static_cast<EventType>(reader.read<std::uint8_t>());
+
+		if (event.type == KEY)
+		{
+			event.x = reader.read<std::int16_t>();
+			event.y = reader.read<std::uint8_t>();
+		}
+		else if (event.type == CURSOR_POS || event.type == SCROLL)
+		{
+			event.x = reader.read<double>();
+			event.y = reader.read<double>();
+		}
+		else
+			throw std::runtime_error("Error: InputRecording::deserialize(): Unknown event type.\n");
+	}
+
+	return recording;
+}
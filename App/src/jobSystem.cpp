@@ -0,0 +1,396 @@
+#include <utility>
+#include <iostream>
+#include <stdexcept>
+
+#include "jobSystem.h"
+#include "trace.h"
+
+
+thread_local int JobSystem::workerIndex = -1;
+
+std::vector<std::unique_ptr<JobSystem::Worker>> JobSystem::workers;
+std::atomic<bool> JobSystem::running = false;
+std::atomic<bool> JobSystem::stopping = false;
+
+std::mutex JobSystem::queueMutex;
+std::deque<JobSystem::Job*> JobSystem::queue;
+
+std::atomic<std::int64_t> JobSystem::queued = 0;
+std::atomic<unsigned int> JobSystem::sleeping = 0;
+std::mutex JobSystem::sleepMutex;
+std::condition_variable JobSystem::wakeUp;
+
+JobSystem::Counter::Counter()
+	: count{ 0 }
+{
+
+}
+
+bool JobSystem::Counter::done() const
+{
+	return count.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::Deque::Deque()
+	: top{ 0 }
+	, bottom{ 0 }
+	, buffer{ std::make_unique<std::atomic<Job*>[]>(capacity) }
+{
+
+}
+
+bool JobSystem::Deque::push(Job* job)
+{
+	std::int64_t b = bottom.load(std::memory_order_relaxed);
+	std::int64_t t = top.load(std::memory_order_acquire);
+
+	if (b - t >= capacity)
+		return false;
+
+	buffer[b & (capacity - 1)].store(job, std::memory_order_relaxed);
+	bottom.store(b + 1, std::memory_order_release);
+
+	return true;
+}
+
+JobSystem::Job* JobSystem::Deque::pop()
+{
+	std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t t = top.load(std::memory_order_relaxed);
+
+	if (t > b)
+	{
+		// empty
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = buffer[b & (capacity - 1)].load(std::memory_order_relaxed);
+
+	// the last job, a thief may be taking it at the same time
+	if (t == b)
+	{
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+JobSystem::Job* JobSystem::Deque::steal()
+{
+	std::int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t b = bottom.load(std::memory_order_acquire);
+
+	if (t >= b)
+		return nullptr;
+
+	Job* job = buffer[t & (capacity - 1)].load(std::memory_order_relaxed);
+
+	// lost the race against the owner or another thief
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+
+	return job;
+}
+
+void JobSystem::start(unsigned int workerCount)
+{
+	if (running)
+		return;
+
+	if (workerCount == 0)
+		workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	for (unsigned int i = 0; i <= workerCount; i++)
+	{
+		workers.push_back(std::make_unique<Worker>());
+		workers.back()->jobs = std::make_unique<Job[]>(jobPoolSize);
+	}
+
+	stopping = false;
+	running = true;
+	workerIndex = 0;
+
+	for (unsigned int i = 1; i <= workerCount; i++)
+		workers[i]->thread = std::thread(workerMain, static_cast<int>(i));
+}
+
+void JobSystem::stop()
+{
+	if (!running)
+		return;
+
+	while (Job* job = take())
+		execute(job);
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	// the workers finish what is still queued before they return
+	for (std::size_t i = 1; i < workers.size(); i++)
+		workers[i]->thread.join();
+
+	running = false;
+	workerIndex = -1;
+	workers.clear();
+}
+
+bool JobSystem::isRunning()
+{
+	return running.load(std::memory_order_acquire);
+}
+
+unsigned int JobSystem::getThreadCount()
+{
+	return isRunning() ? static_cast<unsigned int>(workers.size()) : 1;
+}
+
+void JobSystem::run(std::function<void()> function, Counter* counter, Counter* dependency)
+{
+	Job* job = allocate();
+	job->function = std::move(function);
+	job->range = nullptr;
+	job->counter = counter;
+
+	if (counter != nullptr)
+		counter->count.fetch_add(1, std::memory_order_relaxed);
+
+	submit(job, dependency);
+}
+
+void JobSystem::wait(Counter& counter)
+{
+	while (counter.count.load(std::memory_order_acquire) != 0)
+	{
+		if (Job* job = take())
+			execute(job);
+		else
+			std::this_thread::yield();
+	}
+
+	std::exception_ptr error;
+	{
+		// the last job to finish may still hold the lock
+		std::lock_guard<std::mutex> lock(counter.mutex);
+		error = std::exchange(counter.error, nullptr);
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+JobSystem::Job* JobSystem::allocate()
+{
+	if (workerIndex >= 0)
+	{
+		Worker& worker = *workers[workerIndex];
+		Job& job = worker.jobs[worker.nextJob % jobPoolSize];
+
+		if (!job.busy.load(std::memory_order_acquire))
+		{
+			worker.nextJob++;
+			job.busy.store(true, std::memory_order_relaxed);
+			job.pooled = true;
+			return &job;
+		}
+	}
+
+	Job* job = new Job();
+	job->pooled = false;
+	return job;
+}
+
+void JobSystem::submit(Job* job, Counter* dependency)
+{
+	if (dependency != nullptr)
+	{
+		// the counter is decremented under the lock, so it can't reach zero
+		// between the check and adding the continuation
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+
+		if (dependency->count.load(std::memory_order_acquire) != 0)
+		{
+			dependency->continuations.push_back(job);
+			return;
+		}
+	}
+
+	push(job);
+}
+
+void JobSystem::push(Job* job)
+{
+	if (!isRunning())
+	{
+		execute(job);
+		return;
+	}
+
+	if (workerIndex >= 0)
+	{
+		if (!workers[workerIndex]->deque.push(job))
+		{
+			execute(job);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		queue.push_back(job);
+	}
+
+	queued.fetch_add(1);
+
+	// a worker going to sleep either sees the job or is seen sleeping
+	if (sleeping.load() != 0)
+	{
+		{ std::lock_guard<std::mutex> lock(sleepMutex); }
+		wakeUp.notify_one();
+	}
+}
+
+JobSystem::Job* JobSystem::take()
+{
+	if (!isRunning())
+		return nullptr;
+
+	Job* job = nullptr;
+
+	if (workerIndex >= 0)
+		job = workers[workerIndex]->deque.pop();
+
+	// victims are tried starting after the own deque, so the thieves don't
+	// all go for the same one
+	std::size_t count = workers.size();
+	std::size_t start = static_cast<std::size_t>(workerIndex + 1);
+
+	for (std::size_t i = 0; i < count && job == nullptr; i++)
+	{
+		std::size_t victim = (start + i) % count;
+
+		if (static_cast<int>(victim) != workerIndex)
+			job = workers[victim]->deque.steal();
+	}
+
+	if (job == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+
+		if (!queue.empty())
+		{
+			job = queue.front();
+			queue.pop_front();
+		}
+	}
+
+	if (job != nullptr)
+		queued.fetch_sub(1);
+
+	return job;
+}
+
+void JobSystem::execute(Job* job)
+{
+	std::exception_ptr error;
+
+	try
+	{
+		if (job->range != nullptr)
+			job->range(job->rangeFunction, job->first, job->last);
+		else
+			job->function();
+	}
+	catch (...) { error = std::current_exception(); }
+
+	Counter* counter = job->counter;
+
+	if (job->pooled)
+	{
+		job->function = nullptr;
+		job->busy.store(false, std::memory_order_release);
+	}
+	else
+		delete job;
+
+	finish(counter, error);
+}
+
+void JobSystem::finish(Counter* counter, std::exception_ptr error)
+{
+	if (counter == nullptr)
+	{
+		if (error)
+		{
+			try { std::rethrow_exception(error); }
+			catch (const std::exception& e) { std::cerr << "Error: JobSystem: job failed: " << e.what(); }
+			catch (...) { std::cerr << "Error: JobSystem: job failed." << std::endl; }
+		}
+
+		return;
+	}
+
+	std::vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+
+		if (error && !counter->error)
+			counter->error = error;
+
+		if (counter->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			continuations.swap(counter->continuations);
+	}
+
+	// the counter may be gone already
+	for (Job* job : continuations)
+		push(job);
+}
+
+void JobSystem::runRange(RangeFunction range, const void* function,
+	std::size_t first, std::size_t last, Counter& counter)
+{
+	Job* job = allocate();
+	job->function = nullptr;
+	job->range = range;
+	job->rangeFunction = function;
+	job->first = first;
+	job->last = last;
+	job->counter = &counter;
+
+	counter.count.fetch_add(1, std::memory_order_relaxed);
+
+	push(job);
+}
+
+void JobSystem::workerMain(int index)
+{
+	workerIndex = index;
+	TRACE_THREAD_NAME("worker");
+
+	while (true)
+	{
+		if (Job* job = take())
+		{
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+
+		sleeping.fetch_add(1);
+		wakeUp.wait(lock, []() { return queued.load() > 0 || stopping.load(); });
+		sleeping.fetch_sub(1);
+
+		if (stopping && queued.load() <= 0)
+			return;
+	}
+}
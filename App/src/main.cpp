@@ -1,4 +1,9 @@
 #include <memory>
+#include <charconv>
+#include <string>
+#include <iostream>
+#include <unordered_set>
+#include <filesystem>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
@@ -7,36 +12,232 @@
 #include "camera.h"
 #include "model.h"
 #include "textRenderer.h"
+#include "assets.h"
+#include "derivedDataCache.h"
+#include "assetRegistry.h"
+#include "profiler.h"
+#include "trace.h"
+#include "glStatistics.h"
+#include "inputRecording.h"
+#include "frameTimes.h"
+#include "frustum.h"
+#include "startupReport.h"
+#include "allocationTracker.h"
+#include "frameArena.h"
+#include "glHandlePool.h"
+#include "gpuMemory.h"
+#include "jobSystem.h"
 
 
 int main(int argC, char* argV[])
 {
-	Window window{ 800, 800, "OpenGL", false, true };
+	// assets are read from the asset pack when it exists, --loose reads the
+	// loose files from resources/ and src/shader/ instead (for development);
+	// --profile shows frame timings and OpenGL calls on screen,
+	// --gl-stats <file> writes the OpenGL calls of the last frames as JSON,
+	// --trace-hitch <ms> writes a trace when a frame takes longer (F12 writes
+	// one any time); --headless <frames> renders offscreen without a display
+	// for the given number of frames and prints frame time statistics
+	//
+	// --record <file> records the input and frame times of the run,
+	// --replay <file> plays a recording back with a fixed timestep of
+	// --timestep <s> (1/60 s by default, 0 replays the recorded times) and
+	// ends with it; --report <file> writes the frame time percentiles as JSON
+	//
+	// --startup prints where the time until the first frame went (phases and
+	// assets, split into I/O, decoding and upload), --startup-report <file>
+	// writes it as JSON
+	//
+	// --allocations prints the heap allocations per frame and per tagged
+	// scope on exit, --assert-allocations aborts when a hot scope allocates
+	// after the first frame (both need APP_ENABLE_ALLOCATION_TRACKING)
+	//
+	// --gpu-budget <MiB> overrides the video memory budget derived from
+	// the device, e.g. to see how textures degrade on smaller GPUs
+	std::filesystem::path packPath = "assets.pak";
+	bool looseFiles = false;
+	bool profile = false;
+	std::filesystem::path glStatisticsPath;
+	double hitchThreshold = 0.0;
+	bool headless = false;
+	long long frameLimit = 0;
+	std::filesystem::path recordPath;
+	std::filesystem::path replayPath;
+	double timestep = 1.0 / 60.0;
+	std::filesystem::path reportPath;
+	bool startup = false;
+	std::filesystem::path startupReportPath;
+	bool allocations = false;
+	bool assertAllocations = false;
+	double gpuBudget = 0.0;
+
+	for (int i = 1; i < argC; i++)
+	{
+		std::string arg = argV[i];
+
+		if (arg == "--loose")
+			looseFiles = true;
+		else if (arg == "--pack" && i + 1 < argC)
+			packPath = argV[++i];
+		else if (arg == "--profile")
+			profile = true;
+		else if (arg == "--gl-stats" && i + 1 < argC)
+			glStatisticsPath = argV[++i];
+		else if (arg == "--trace-hitch" && i + 1 < argC)
+			hitchThreshold = std::stod(argV[++i]);
+		else if (arg == "--headless" && i + 1 < argC)
+		{
+			headless = true;
+			frameLimit = std::stoll(argV[++i]);
+		}
+		else if (arg == "--record" && i + 1 < argC)
+			recordPath = argV[++i];
+		else if (arg == "--replay" && i + 1 < argC)
+			replayPath = argV[++i];
+		else if (arg == "--timestep" && i + 1 < argC)
+			timestep = std::stod(argV[++i]);
+		else if (arg == "--report" && i + 1 < argC)
+			reportPath = argV[++i];
+		else if (arg == "--startup")
+			startup = true;
+		else if (arg == "--startup-report" && i + 1 < argC)
+			startupReportPath = argV[++i];
+		else if (arg == "--allocations")
+			allocations = true;
+		else if (arg == "--assert-allocations")
+			assertAllocations = true;
+		else if (arg == "--gpu-budget" && i + 1 < argC)
+			gpuBudget = std::stod(argV[++i]);
+	}
+
+	// headless runs measure the scopes as well
+	Profiler::setEnabled(profile || headless);
+
+	TRACE_THREAD_NAME("main");
+#ifdef APP_ENABLE_TRACING
+	Trace::setHitchThreshold(hitchThreshold);
+#else
+	(void)hitchThreshold;
+#endif
+
+#ifndef APP_ENABLE_ALLOCATION_TRACKING
+	if (allocations || assertAllocations)
+		std::cerr << "Error: AllocationTracker: not compiled in, build with APP_ENABLE_ALLOCATION_TRACKING" << std::endl;
+#endif
+
+	GPUMemory::setBudget(static_cast<std::uint64_t>(gpuBudget * 1024.0 * 1024.0));
+
+	// glyph rasterization and culling run on the job system, the main
+	// thread takes part while it waits
+	JobSystem::start();
+
+	if (!looseFiles && std::filesystem::exists(packPath))
+	{
+		StartupReport::Phase phase("asset pack");
+		Assets::mountPack(packPath);
+	}
+
+	StartupReport::beginPhase("window");
+	Window window{ 800, 800, "OpenGL", false, !headless, headless };
+	StartupReport::endPhase();
+
+	// GLEW's entry points are wrapped once they are loaded
+	if (profile || !glStatisticsPath.empty())
+		GLStatistics::install();
+
 	Camera camera{ glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 0.0f) };
+
+	StartupReport::beginPhase("shaders");
 	Shader mainShader{ "src/shader/main.vert", "src/shader/main.frag" };
-	Shader textShader{ "src/shader/text.vert", "src/shader/text.frag" };
+	Shader textShader{ "src/shader/text.vert", "src/shader/textSdf.frag" };
 	Shader lampShader{ "src/shader/lamp.vert", "src/shader/lamp.frag" };
-	TextRenderer textRenderer{ "resources/font/consola.ttf", 0, 30 };
+	StartupReport::endPhase();
+
+	StartupReport::beginPhase("text renderer");
+	TextRenderer textRenderer{ "resources/font/consola.ttf", 0, 30, FontData::SDF };
+	TextLayout fpsLayout;
+	StartupReport::endPhase();
 	
 	window.addKeyCallback(camera.getKeyCallback());
 	window.addCursorPosCallback(camera.getCursorPosCallback());
 	window.addScrollCallback(camera.getScrollCallback());
 
-	Model backpack{ "resources/objects/backpack/backpack.obj" };
-	Model container{ "resources/objects/container/container.obj" };
-	Model lamp{ "resources/objects/lamp/lamp.obj" };
+#ifdef APP_ENABLE_TRACING
+	window.addKeyCallback([dumpKeyDown = false](Window* window) mutable
+	{
+		bool keyDown = window->getKeyStatus(GLFW_KEY_F12);
+
+		if (keyDown && !dumpKeyDown && Trace::dump("trace.json"))
+			std::cout << "Info: Trace: trace written to trace.json" << std::endl;
+
+		dumpKeyDown = keyDown;
+	});
+#endif
+
+	// nothing reads the geometry back, culling uses the models' bounds
+	StartupReport::beginPhase("models");
+	std::shared_ptr<Model> backpack = Model::load("resources/objects/backpack/backpack.obj", Mesh::DROP);
+	std::shared_ptr<Model> container = Model::load("resources/objects/container/container.obj", Mesh::DROP);
+	std::shared_ptr<Model> lamp = Model::load("resources/objects/lamp/lamp.obj", Mesh::DROP);
+	StartupReport::endPhase();
+
+	// textures are shared by meshes, each is counted once
+	{
+		std::unordered_set<const Texture*> textures;
+		unsigned int skippedTextures = 0;
+		unsigned int skippedLevels = 0;
+
+		for (const std::shared_ptr<Model>& model : { backpack, container, lamp })
+		{
+			for (const std::shared_ptr<Mesh>& mesh : model->getMeshes())
+			{
+				for (const std::shared_ptr<Texture>& texture : mesh->getTextures())
+				{
+					if (texture->getSkippedLevels() > 0 && textures.insert(texture.get()).second)
+					{
+						skippedTextures++;
+						skippedLevels += texture->getSkippedLevels();
+					}
+				}
+			}
+		}
+
+		if (skippedTextures > 0)
+		{
+			std::cout
+				<< "Info: Texture: " << skippedTextures << " textures loaded without their largest mip levels ("
+				<< skippedLevels << " levels), over the video memory budget" << std::endl;
+		}
+	}
 
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 	glm::vec3 lightPos(0.0f, 0.0f, 3.0f);
 
+	// recording and replaying start with the first frame, after loading
+	InputRecording recording;
+	if (!replayPath.empty())
+	{
+		recording = InputRecording::load(replayPath);
+		window.startReplay(recording, timestep);
+	}
+	else if (!recordPath.empty())
+		window.startRecording(recording);
+
+	FrameTimes frameTimes;
+	bool measure = headless || !reportPath.empty();
+	long long frameCount = 0;
+
 	// game loop
-	while (!glfwWindowShouldClose(window))
+	while (!glfwWindowShouldClose(window) && (!headless || frameCount < frameLimit))
 	{
+		ALLOCATION_SCOPE("frame");
+
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		lightPos.x = 1.0f + sin(glfwGetTime()) * 2.0f;
-		lightPos.y = sin(glfwGetTime() / 2.0f) * 1.0f;
+		// the window's time, so replays move the light the same way
+		lightPos.x = 1.0f + sin(window.getTime()) * 2.0f;
+		lightPos.y = sin(window.getTime() / 2.0f) * 1.0f;
 
 		// manually call key callback every frame for smother movement
 		camera.getKeyCallback()(&window);
@@ -57,18 +258,132 @@ int main(int argC, char* argV[])
 		mainShader.setUniform1f("material.shininess", 64.0f);
 
 
-		backpack.draw(mainShader);
-		lamp.draw(lampShader, lightPos, 0.25f);
-		
-		textRenderer.renderText(
-			textShader,
-			std::to_string(window.getFPS()),
-			0.0f, static_cast<float>(textRenderer.getMaxNumberHeight() + 1),
-			TextRenderer::TOP_LEFT
-		);
+		{
+			Profiler::Scope scope("models");
+
+			// models outside the view aren't drawn, the boxes and the result
+			// only live for the frame
+			FrameArena::Vector<std::uint32_t> visible(FrameArena::resource());
+			{
+				ALLOCATION_HOT_SCOPE("culling");
+
+				Frustum frustum(
+					camera.getProjMatrix(static_cast<GLfloat>(window.getWidth()), static_cast<GLfloat>(window.getHeight()))
+					* camera.getViewMatrix()
+				);
+
+				FrameArena::Vector<AABB> bounds(FrameArena::resource());
+				bounds.push_back(backpack->getBounds());
+				bounds.push_back(lamp->getBounds().transform(Model::getModelMatrix(lightPos, 0.25f)));
+
+				frustum.cull(bounds, visible);
+			}
+
+			for (std::uint32_t index : visible)
+			{
+				if (index == 0)
+					backpack->draw(mainShader);
+				else
+					lamp->draw(lampShader, lightPos, 0.25f);
+			}
+		}
+
+		{
+			Profiler::Scope scope("text");
+
+			char fps[16];
+			std::to_chars_result fpsEnd = std::to_chars(fps, fps + sizeof(fps), window.getFPS());
 
+			textRenderer.renderText(
+				textShader,
+				fpsLayout,
+				std::string_view(fps, fpsEnd.ptr - fps),
+				0.0f, static_cast<float>(textRenderer.getMaxNumberHeight() + 1),
+				TextRenderer::TOP_LEFT
+			);
+
+			if (profile)
+				Profiler::renderOverlay(textRenderer, textShader, 0.0f, static_cast<float>(textRenderer.getMaxNumberHeight() + 1));
+
+			// draws all text of this frame at once
+			textRenderer.endFrame();
+		}
+
+		Profiler::endFrame();
+		GLStatistics::endFrame();
+		ALLOCATION_FRAME();
+		TRACE_FRAME();
 		window.update();
+
+		// the first frame is on screen, the startup is over
+		if (frameCount == 0)
+		{
+			StartupReport::finish();
+
+			// everything allocated once (glyphs, arena blocks) is in place
+			// now; models drawn later look up their sampler locations
+			// before they enter the hot scope
+#ifdef APP_ENABLE_ALLOCATION_TRACKING
+			AllocationTracker::setAssertMode(assertAllocations);
+#endif
+
+			if (startup)
+				StartupReport::print(std::cout);
+
+			if (!startupReportPath.empty())
+			{
+				if (StartupReport::writeJson(startupReportPath))
+					std::cout << "Info: StartupReport: startup report written to " << startupReportPath.string() << std::endl;
+				else
+					std::cerr << "Error: StartupReport: couldn't write " << startupReportPath.string() << std::endl;
+			}
+		}
+
+		// the first frame's time includes loading the assets
+		if (measure && frameCount > 0)
+			frameTimes.add(window.getFrameTime() * 1000.0);
+
+		frameCount++;
+	}
+
+	if (!recordPath.empty() && replayPath.empty())
+	{
+		window.stopRecording();
+		recording.save(recordPath);
+		std::cout << "Info: InputRecording: " << recording.getFrameCount() << " frames recorded to " << recordPath.string() << std::endl;
+	}
+
+	if (!frameTimes.empty())
+	{
+		std::string name = replayPath.empty() ? "app" : replayPath.stem().string();
+		frameTimes.print(std::cout, name);
+
+		if (!reportPath.empty() && !frameTimes.writeJson(reportPath, name))
+			std::cerr << "Error: FrameTimes: couldn't write " << reportPath.string() << std::endl;
 	}
 
+	if (Profiler::isEnabled())
+		Profiler::printStatistics(std::cout);
+
+	if (!glStatisticsPath.empty())
+	{
+		if (GLStatistics::dump(glStatisticsPath))
+			std::cout << "Info: GLStatistics: OpenGL calls written to " << glStatisticsPath.string() << std::endl;
+		else
+			std::cerr << "Error: GLStatistics: couldn't write " << glStatisticsPath.string() << std::endl;
+	}
+
+#ifdef APP_ENABLE_ALLOCATION_TRACKING
+	if (allocations)
+		AllocationTracker::print(std::cout);
+#endif
+
+	AssetRegistry::printInfo(std::cout);
+	GLHandlePool::printStatistics(std::cout);
+	GPUMemory::printStatistics(std::cout);
+	DerivedDataCache::printStatistics(std::cout);
+
+	JobSystem::stop();
+
 	return 0;
 }
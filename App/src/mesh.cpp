@@ -1,47 +1,90 @@
+#include <charconv>
+#include <sstream>
+#include <stdexcept>
+
 #include "mesh.h"
+#include "modelData.h"
+#include "trace.h"
+#include "glStatistics.h"
+#include "allocationTracker.h"
+#include "glHandlePool.h"
 
 
 Mesh::Mesh(
 	const std::vector<Vertex>& vertices,
 	const std::vector<GLuint>& indices,
-	const std::vector<std::shared_ptr<Texture>>& textures
+	const std::vector<std::shared_ptr<Texture>>& textures,
+	Retention retention,
+	const std::filesystem::path& source,
+	std::size_t sourceIndex
 )
 	: vertices{ vertices }
 	, indices{ indices }
 	, textures{ textures }
+	, samplerProgram{ 0 }
+	, retention{ retention }
+	, source{ source }
+	, sourceIndex{ sourceIndex }
+	, vertexCount{ 0 }
+	, indexCount{ 0 }
 	, VAO{ 0 }
 	, VBO{ 0 }
 	, EBO{ 0 }
 {
 	setupGLObjects();
+	setupSamplerNames();
+	applyRetention();
 }
 
 Mesh::Mesh(
 	std::vector<Vertex>&& vertices,
 	std::vector<GLuint>&& indices,
-	std::vector<std::shared_ptr<Texture>>&& textures
+	std::vector<std::shared_ptr<Texture>>&& textures,
+	Retention retention,
+	const std::filesystem::path& source,
+	std::size_t sourceIndex
 )
 	: vertices{ std::move(vertices) }
 	, indices{ std::move(indices) }
 	, textures{ std::move(textures) }
+	, samplerProgram{ 0 }
+	, retention{ retention }
+	, source{ source }
+	, sourceIndex{ sourceIndex }
+	, vertexCount{ 0 }
+	, indexCount{ 0 }
 	, VAO{ 0 }
 	, VBO{ 0 }
 	, EBO{ 0 }
 {
 	setupGLObjects();
+	setupSamplerNames();
+	applyRetention();
 }
 
 Mesh::Mesh(Mesh&& other) noexcept
 	: vertices{ std::move(other.vertices) }
 	, indices{ std::move(other.indices) }
+	, positions{ std::move(other.positions) }
 	, textures{ std::move(other.textures) }
+	, samplerNames{ std::move(other.samplerNames) }
+	, samplerLocations{ std::move(other.samplerLocations) }
+	, samplerProgram{ other.samplerProgram }
+	, retention{ other.retention }
+	, source{ std::move(other.source) }
+	, sourceIndex{ other.sourceIndex }
+	, vertexCount{ other.vertexCount }
+	, indexCount{ other.indexCount }
 	, VAO{ other.VAO }
 	, VBO{ other.VBO }
 	, EBO{ other.EBO }
+	, gpuMemory{ std::move(other.gpuMemory) }
 {
 	other.VAO = 0;
 	other.VBO = 0;
 	other.EBO = 0;
+	other.vertexCount = 0;
+	other.indexCount = 0;
 }
 
 Mesh::~Mesh()
@@ -57,14 +100,26 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept
 
 		vertices = std::move(other.vertices);
 		indices = std::move(other.indices);
+		positions = std::move(other.positions);
 		textures = std::move(other.textures);
+		samplerNames = std::move(other.samplerNames);
+		samplerLocations = std::move(other.samplerLocations);
+		samplerProgram = other.samplerProgram;
+		retention = other.retention;
+		source = std::move(other.source);
+		sourceIndex = other.sourceIndex;
+		vertexCount = other.vertexCount;
+		indexCount = other.indexCount;
 		VAO = other.VAO;
 		VBO = other.VBO;
 		EBO = other.EBO;
+		gpuMemory = std::move(other.gpuMemory);
 
 		other.VAO = 0;
 		other.VBO = 0;
 		other.EBO = 0;
+		other.vertexCount = 0;
+		other.indexCount = 0;
 	}
 
 	return *this;
@@ -72,60 +127,126 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept
 
 const std::vector<Vertex>& Mesh::getVertices() const
 {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (vertices.empty() && vertexCount > 0)
+		reload();
+
 	return vertices;
 }
 
 const std::vector<GLuint>& Mesh::getIndices() const
 {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (indices.empty() && indexCount > 0)
+		reload();
+
 	return indices;
 }
 
+const std::vector<glm::vec3>& Mesh::getPositions() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (positions.empty() && vertexCount > 0)
+	{
+		if (vertices.empty())
+			reload();
+
+		positions.reserve(vertices.size());
+		for (const Vertex& vertex : vertices)
+			positions.push_back(vertex.position);
+	}
+
+	return positions;
+}
+
 const std::vector<std::shared_ptr<Texture>>& Mesh::getTextures() const
 {
 	return textures;
 }
 
-void Mesh::draw(Shader& shader)
+Mesh::Retention Mesh::getRetention() const
 {
-	unsigned int diffuseIdx = 1;
-	unsigned int specularIdx = 1;
-	unsigned int normalIdx = 1;
-	unsigned int heightIdx = 1;
+	std::lock_guard<std::mutex> lock(mutex);
+	return retention;
+}
 
-	for (GLint i = 0; i < textures.size(); i++)
-	{
-		std::string name = textures[i]->getName();
-		std::string idx;
+void Mesh::retain(Retention retention)
+{
+	// DROP keeps the least, KEEP the most
+	auto rank = [](Retention retention) { return retention == KEEP ? 2 : retention == POSITIONS_ONLY ? 1 : 0; };
 
-		if (name == "texture_diffuse")
-		{
-			idx = std::to_string(diffuseIdx);
-			diffuseIdx++;
-		}
-		else if (name == "texture_specular")
-		{
-			idx = std::to_string(specularIdx);
-			specularIdx++;
-		}
-		else if (name == "texture_normal")
-		{
-			idx = std::to_string(normalIdx);
-			normalIdx++;
-		}
-		else if (name == "texture_height")
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (rank(retention) <= rank(this->retention))
+		return;
+
+	if (vertexCount > 0 && (vertices.empty() || indices.empty()))
+		reload();
+
+	if (retention == POSITIONS_ONLY)
+	{
+		// built already if they were asked for
+		if (positions.empty())
 		{
-			idx = std::to_string(heightIdx++);
-			heightIdx++;
+			positions.reserve(vertices.size());
+			for (const Vertex& vertex : vertices)
+				positions.push_back(vertex.position);
 		}
 
+		std::vector<Vertex>().swap(vertices);
+	}
+
+	this->retention = retention;
+}
+
+std::size_t Mesh::getMemorySize() const
+{
+	return getBufferSize() + getRetainedSize();
+}
+
+std::size_t Mesh::getBufferSize() const
+{
+	return static_cast<std::size_t>(vertexCount) * sizeof(Vertex) + static_cast<std::size_t>(indexCount) * sizeof(GLuint);
+}
+
+std::size_t Mesh::getRetainedSize() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return
+		vertices.size() * sizeof(Vertex) +
+		indices.size() * sizeof(GLuint) +
+		positions.size() * sizeof(glm::vec3);
+}
+
+void Mesh::draw(Shader& shader)
+{
+	// looked up before the hot scope, once per program
+	if (samplerProgram != shader.getProgram())
+	{
+		for (std::size_t i = 0; i < samplerNames.size(); i++)
+			samplerLocations[i] = shader.findUniformLocation(samplerNames[i]);
+
+		samplerProgram = shader.getProgram();
+	}
+
+	ALLOCATION_HOT_SCOPE("mesh draw");
+
+	for (GLint i = 0; i < textures.size(); i++)
+	{
 		glActiveTexture(GL_TEXTURE0 + i);
-		shader.setUniform1i("material" + name + idx, i);
+		glUniform1i(samplerLocations[i], i);
 		glBindTexture(GL_TEXTURE_2D, textures[i]->getId());
+		GLStatistics::count(GLStatistics::STATE_CHANGES);
 		glActiveTexture(GL_TEXTURE0);
 	}
 
 	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+	GLStatistics::count(GLStatistics::DRAW_CALLS);
 	glBindVertexArray(0);
 }
 
@@ -133,12 +254,15 @@ void Mesh::setupGLObjects()
 {
 	deleteGLObjects();
 
+	vertexCount = static_cast<GLsizei>(vertices.size());
+	indexCount = static_cast<GLsizei>(indices.size());
+
 // VAO begin
-	glGenVertexArrays(1, &VAO);
+	VAO = GLHandlePool::acquire(GLHandlePool::VERTEX_ARRAY);
 	glBindVertexArray(VAO);
 
 	// VBO begin
-	glGenBuffers(1, &VBO);
+	VBO = GLHandlePool::acquire(GLHandlePool::BUFFER);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
 
@@ -154,7 +278,7 @@ void Mesh::setupGLObjects()
 	// VBO end
 
 	// EBO begin
-	glGenBuffers(1, &EBO);
+	EBO = GLHandlePool::acquire(GLHandlePool::BUFFER);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 	// EBO end
@@ -163,11 +287,119 @@ void Mesh::setupGLObjects()
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 // VAO end
+
+	gpuMemory = GPUMemory::Allocation(GPUMemory::GEOMETRY, getBufferSize());
 }
 
 void Mesh::deleteGLObjects()
 {
-	glDeleteBuffers(1, &EBO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteVertexArrays(1, &VAO);
+	GLHandlePool::release(GLHandlePool::BUFFER, EBO);
+	GLHandlePool::release(GLHandlePool::BUFFER, VBO);
+	GLHandlePool::release(GLHandlePool::VERTEX_ARRAY, VAO);
+
+	EBO = 0;
+	VBO = 0;
+	VAO = 0;
+
+	gpuMemory = GPUMemory::Allocation();
+}
+
+void Mesh::setupSamplerNames()
+{
+	unsigned int diffuseIdx = 1;
+	unsigned int specularIdx = 1;
+	unsigned int normalIdx = 1;
+	unsigned int heightIdx = 1;
+
+	samplerNames.clear();
+	samplerNames.reserve(textures.size());
+
+	for (const std::shared_ptr<Texture>& texture : textures)
+	{
+		const std::string& name = texture->getName();
+		unsigned int idx = 0;
+
+		if (name == "texture_diffuse")
+		{
+			idx = diffuseIdx;
+			diffuseIdx++;
+		}
+		else if (name == "texture_specular")
+		{
+			idx = specularIdx;
+			specularIdx++;
+		}
+		else if (name == "texture_normal")
+		{
+			idx = normalIdx;
+			normalIdx++;
+		}
+		else if (name == "texture_height")
+		{
+			idx = heightIdx++;
+			heightIdx++;
+		}
+
+		std::string uniformName = "material" + name;
+
+		// unknown texture types have no index
+		if (idx != 0)
+		{
+			char digits[16];
+			uniformName.append(digits, std::to_chars(digits, digits + sizeof(digits), idx).ptr);
+		}
+
+		samplerNames.push_back(std::move(uniformName));
+	}
+
+	// resolved on the first draw
+	samplerLocations.assign(samplerNames.size(), -1);
+	samplerProgram = 0;
+}
+
+void Mesh::applyRetention()
+{
+	// without a source, dropped data couldn't be read again
+	if (source.empty())
+		retention = KEEP;
+
+	if (retention == KEEP)
+		return;
+
+	if (retention == POSITIONS_ONLY)
+	{
+		positions.reserve(vertices.size());
+		for (const Vertex& vertex : vertices)
+			positions.push_back(vertex.position);
+	}
+	else
+		std::vector<GLuint>().swap(indices);
+
+	std::vector<Vertex>().swap(vertices);
+}
+
+void Mesh::reload() const
+{
+	TRACE_SCOPE("reload mesh", source.string());
+
+	ModelData data = ModelData::load(source);
+
+	// the source has to be what the buffers were uploaded from
+	if (sourceIndex >= data.meshes.size() ||
+		data.meshes[sourceIndex].vertices.size() != static_cast<std::size_t>(vertexCount) ||
+		data.meshes[sourceIndex].indices.size() != static_cast<std::size_t>(indexCount))
+	{
+		std::stringstream errorMessage;
+		errorMessage
+			<< "Error: Mesh::reload(): "
+			<< source.string() << " changed since mesh " << sourceIndex << " was uploaded."
+			<< std::endl;
+
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	if (vertices.empty())
+		vertices = std::move(data.meshes[sourceIndex].vertices);
+	if (indices.empty())
+		indices = std::move(data.meshes[sourceIndex].indices);
 }
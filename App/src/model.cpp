@@ -1,147 +1,142 @@
-#include <sstream>
+#include <string>
 #include <utility>
+#include <unordered_set>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "model.h"
+#include "modelData.h"
+#include "assetRegistry.h"
+#include "assetPack.h"
+#include "trace.h"
+#include "startupReport.h"
+#include "allocationTracker.h"
 
 
-Model::Model(const std::filesystem::path& path)
+Model::Model(const std::filesystem::path& path, Mesh::Retention retention)
+	: Model(path, AssetRegistry::contentHash(path), retention)
 {
-	baseDir = path.parent_path();
 
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path.string(), aiProcess_Triangulate | aiProcess_FlipUVs);
-
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-	{
-		std::stringstream errorMessage;
-		errorMessage
-			<< "Error: Model::readFile(): "
-			<< importer.GetErrorString()
-			<< std::endl;
-
-		throw std::runtime_error(errorMessage.str());
-	}
-
-	processNode(scene->mRootNode, scene);
 }
 
-void Model::draw(Shader& shader, glm::vec3 pos, GLfloat scale,
-	glm::vec3 axis, GLfloat angle)
+Model::Model(const std::filesystem::path& path, std::uint64_t contentHash, Mesh::Retention retention)
 {
-	glm::mat4 model = glm::mat4(1.0f);
+	TRACE_SCOPE("load model", path.string());
+	ALLOCATION_SCOPE("model load");
 
-	model = glm::translate(model, pos);
-	model = glm::scale(model, scale * glm::vec3(1.0f, 1.0f, 1.0f));
-	model = glm::rotate(model, glm::radians(angle), axis);
+	// importing (or reading the cooked result) doesn't need the OpenGL
+	// context, uploading the meshes and textures does
+	ModelData data = ModelData::load(path);
+	std::string modelPath = AssetPack::normalize(path);
 
-	shader.useProgram();
-	shader.setUniformMatrix4fv("model", glm::value_ptr(model));
+	meshes.reserve(data.meshes.size());
 
-	for (Mesh& mesh : meshes)
-		mesh.draw(shader);
-}
-
-void Model::processNode(aiNode* node, const aiScene* scene)
-{
-	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	for (std::size_t i = 0; i < data.meshes.size(); i++)
 	{
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		processMesh(mesh, scene);
-	}
+		ModelData::MeshData& mesh = data.meshes[i];
+
+		for (const Vertex& vertex : mesh.vertices)
+			bounds.extend(vertex.position);
+
+		// meshes are identified by their index inside the model
+		meshes.push_back(AssetRegistry::acquire<Mesh>(
+			AssetRegistry::MESH,
+			modelPath + "#" + std::to_string(i),
+			contentHash,
+			[&]()
+			{
+				std::vector<std::shared_ptr<Texture>> textures;
+
+				for (const ModelData::TextureRef& textureRef : mesh.textures)
+					textures.push_back(Texture::load(textureRef.path, textureRef.name));
+
+				// the textures report their own uploads
+				StartupReport::AssetScope report("model", path, StartupReport::UPLOAD);
+				return std::make_shared<Mesh>(
+					std::move(mesh.vertices),
+					std::move(mesh.indices),
+					std::move(textures),
+					retention,
+					path,
+					i
+				);
+			}
+		));
 
-	for (unsigned int i = 0; i < node->mNumChildren; i++)
-		processNode(node->mChildren[i], scene);
+		// a mesh shared with a model that dropped more keeps what this one
+		// asked for from now on
+		meshes.back()->retain(retention);
+	}
 }
 
-void Model::processMesh(aiMesh* mesh, const aiScene* scene)
+std::shared_ptr<Model> Model::load(const std::filesystem::path& path, Mesh::Retention retention)
 {
-	std::vector<Vertex> vertices;
-	std::vector<GLuint> indices;
-	std::vector<std::shared_ptr<Texture>> textures;
+	std::uint64_t contentHash = AssetRegistry::contentHash(path);
+
+	std::shared_ptr<Model> model = AssetRegistry::acquire<Model>(
+		AssetRegistry::MODEL,
+		AssetPack::normalize(path),
+		contentHash,
+		[&]() { return std::shared_ptr<Model>(new Model(path, contentHash, retention)); }
+	);
 
-	getVertices(vertices, mesh);
-	getIndices(indices, mesh);
-	getTextures(textures, mesh, scene);
+	// a model loaded before with a policy that keeps less is upgraded
+	for (const std::shared_ptr<Mesh>& mesh : model->meshes)
+		mesh->retain(retention);
 
-	meshes.emplace_back(std::move(vertices), std::move(indices), std::move(textures));
+	return model;
 }
 
-void Model::getVertices(std::vector<Vertex>& vertices, aiMesh* mesh)
+std::size_t Model::getMemorySize() const
 {
-	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	std::size_t memorySize = 0;
+	std::unordered_set<const Texture*> textures;
+
+	for (const std::shared_ptr<Mesh>& mesh : meshes)
 	{
-		Vertex vertex;
+		memorySize += mesh->getMemorySize();
 
-		if (mesh->HasPositions())
+		// textures used by several meshes are counted once
+		for (const std::shared_ptr<Texture>& texture : mesh->getTextures())
 		{
-			vertex.position.x = mesh->mVertices[i].x;
-			vertex.position.y = mesh->mVertices[i].y;
-			vertex.position.z = mesh->mVertices[i].z;
+			if (textures.insert(texture.get()).second)
+				memorySize += texture->getMemorySize();
 		}
+	}
 
-		if (mesh->HasNormals())
-		{
-			vertex.normal.x = mesh->mNormals[i].x;
-			vertex.normal.y = mesh->mNormals[i].y;
-			vertex.normal.z = mesh->mNormals[i].z;
-		}
+	return memorySize;
+}
 
-		if (mesh->HasTextureCoords(0))
-		{
-			vertex.texCoords.x = mesh->mTextureCoords[0][i].x;
-			vertex.texCoords.y = mesh->mTextureCoords[0][i].y;
-		}
+glm::mat4 Model::getModelMatrix(glm::vec3 pos, GLfloat scale,
+	glm::vec3 axis, GLfloat angle)
+{
+	glm::mat4 model = glm::mat4(1.0f);
 
-		vertices.push_back(vertex);
-	}
+	model = glm::translate(model, pos);
+	model = glm::scale(model, scale * glm::vec3(1.0f, 1.0f, 1.0f));
+	model = glm::rotate(model, glm::radians(angle), axis);
+
+	return model;
 }
 
-void Model::getIndices(std::vector<GLuint>& indices, aiMesh* mesh)
+const AABB& Model::getBounds() const
 {
-	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-	{
-		aiFace face = mesh->mFaces[i];
-
-		for (unsigned int j = 0; j < face.mNumIndices; j++)
-			indices.push_back(face.mIndices[j]);
-	}
+	return bounds;
 }
 
-void Model::getTextures(std::vector<std::shared_ptr<Texture>>& textures,
-	aiMesh* mesh, const aiScene* scene
-)
+const std::vector<std::shared_ptr<Mesh>>& Model::getMeshes() const
 {
-	if (mesh->mMaterialIndex == 0)
-		return;
+	return meshes;
+}
 
-	aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+void Model::draw(Shader& shader, glm::vec3 pos, GLfloat scale,
+	glm::vec3 axis, GLfloat angle)
+{
+	glm::mat4 model = getModelMatrix(pos, scale, axis, angle);
 
-	std::vector<std::pair<aiTextureType, std::string>> textureTypes = {
-		{ aiTextureType_DIFFUSE, "texture_diffuse" },
-		{ aiTextureType_SPECULAR, "texture_specular" },
-		{ aiTextureType_HEIGHT, "texture_normal" },
-		{ aiTextureType_AMBIENT, "texture_height" }
-	};
+	shader.useProgram();
+	shader.setUniformMatrix4fv("model", glm::value_ptr(model));
 
-	for (const std::pair<aiTextureType, std::string>& textureType : textureTypes)
-	{
-		for (unsigned int i = 0; i < material->GetTextureCount(textureType.first); i++)
-		{
-			aiString str;
-			material->GetTexture(textureType.first, i, &str);
-			std::filesystem::path path = baseDir / str.C_Str();
-
-			auto it = loadedTextures.find(path);
-			if (it != loadedTextures.end())
-				textures.push_back(it->second);
-			else
-			{
-				std::shared_ptr<Texture> texture = std::make_shared<Texture>(path, textureType.second);
-				textures.push_back(texture);
-				loadedTextures[path] = texture;
-			}
-		}
-	}
+	for (const std::shared_ptr<Mesh>& mesh : meshes)
+		mesh->draw(shader);
 }
@@ -0,0 +1,292 @@
+#include <sstream>
+#include <utility>
+#include <optional>
+#include <stdexcept>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+#include "modelData.h"
+#include "assetIOSystem.h"
+#include "binaryStream.h"
+#include "assets.h"
+#include "derivedDataCache.h"
+#include "hash.h"
+#include "trace.h"
+#include "startupReport.h"
+
+
+// joining identical vertices and reordering triangles for the post-transform
+// vertex cache only cost time once, when cooking
+static const unsigned int importFlags =
+	aiProcess_Triangulate |
+	aiProcess_FlipUVs |
+	aiProcess_JoinIdenticalVertices |
+	aiProcess_ImproveCacheLocality;
+
+ModelData ModelData::load(const std::filesystem::path& path)
+{
+	TRACE_SCOPE("read model", path.string());
+	StartupReport::AssetScope report("model", path, StartupReport::IO);
+
+	FileView source = Assets::open(path, FileView::SEQUENTIAL);
+	std::uint64_t key = DerivedDataCache::key(source, params());
+
+	if (std::optional<FileView> cooked = DerivedDataCache::load(key, "model"))
+	{
+		report.next(StartupReport::DECODE);
+		std::optional<ModelData> data = tryDeserialize(*cooked);
+
+		// hashing the dependencies is reading them
+		report.next(StartupReport::IO);
+		if (!data)
+			DerivedDataCache::reject("model");
+		else if (data->isUpToDate())
+			return std::move(*data);
+	}
+
+	report.next(StartupReport::DECODE);
+	ModelData data = import(path);
+
+	report.next(StartupReport::IO);
+	try { DerivedDataCache::store(key, "model", data.serialize()); }
+	catch (const std::runtime_error&) {}
+
+	return data;
+}
+
+ModelData ModelData::import(const std::filesystem::path& path)
+{
+	ModelData data;
+
+	Assimp::Importer importer;
+
+	// the importer takes ownership of the IO handler
+	AssetIOSystem* ioSystem = new AssetIOSystem();
+	importer.SetIOHandler(ioSystem);
+
+	const aiScene* scene = importer.ReadFile(path.string(), importFlags);
+
+	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	{
+		std::stringstream errorMessage;
+		errorMessage
+			<< "Error: ModelData::import(): "
+			<< importer.GetErrorString()
+			<< std::endl;
+
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	data.processNode(scene->mRootNode, scene, path.parent_path());
+
+	// the model file itself is covered by the cooked key
+	std::string modelKey = AssetPack::normalize(path);
+	for (const std::string& file : ioSystem->getOpenedFiles())
+	{
+		if (AssetPack::normalize(file) == modelKey)
+			continue;
+
+		FileView view = Assets::open(file, FileView::SEQUENTIAL);
+		data.dependencies.push_back({ file, hash64(view.data(), view.size()) });
+	}
+
+	return data;
+}
+
+std::vector<std::byte> ModelData::serialize() const
+{
+	BinaryWriter writer;
+
+	writer.write<std::uint32_t>(formatVersion);
+
+	writer.write<std::uint64_t>(dependencies.size());
+	for (const Dependency& dependency : dependencies)
+	{
+		writer.writeString(dependency.path);
+		writer.write<std::uint64_t>(dependency.hash);
+	}
+
+	writer.write<std::uint64_t>(meshes.size());
+	for (const MeshData& mesh : meshes)
+	{
+		writer.writeVector(mesh.vertices);
+		writer.writeVector(mesh.indices);
+
+		writer.write<std::uint64_t>(mesh.textures.size());
+		for (const TextureRef& texture : mesh.textures)
+		{
+			writer.writeString(texture.path);
+			writer.writeString(texture.name);
+		}
+	}
+
+	return std::move(writer.data());
+}
+
+ModelData ModelData::deserialize(const FileView& view)
+{
+	ModelData data;
+	BinaryReader reader(view.data(), view.size());
+
+	if (reader.read<std::uint32_t>() != formatVersion)
+		throw std::runtime_error("Error: ModelData::deserialize(): Unsupported format version.\n");
+
+	// path and hash
+	data.dependencies.resize(reader.readCount(sizeof(std::uint32_t) + sizeof(std::uint64_t)));
+	for (Dependency& dependency : data.dependencies)
+	{
+		dependency.path = reader.readString();
+		dependency.hash = reader.read<std::uint64_t>();
+	}
+
+	// vertex, index and texture counts
+	data.meshes.resize(reader.readCount(3 * sizeof(std::uint64_t)));
+	for (MeshData& mesh : data.meshes)
+	{
+		mesh.vertices = reader.readVector<Vertex>();
+		mesh.indices = reader.readVector<GLuint>();
+
+		// path and name
+		mesh.textures.resize(reader.readCount(2 * sizeof(std::uint32_t)));
+		for (TextureRef& texture : mesh.textures)
+		{
+			texture.path = reader.readString();
+			texture.name = reader.readString();
+		}
+	}
+
+	return data;
+}
+
+std::optional<ModelData> ModelData::tryDeserialize(const FileView& view)
+{
+	// a corrupt entry is imported again
+	try { return deserialize(view); }
+	catch (const std::runtime_error&) {}
+	catch (const std::bad_alloc&) {}
+	catch (const std::length_error&) {}
+
+	return std::nullopt;
+}
+
+bool ModelData::isUpToDate() const
+{
+	for (const Dependency& dependency : dependencies)
+	{
+		if (!Assets::exists(dependency.path))
+			return false;
+
+		FileView view = Assets::open(dependency.path, FileView::SEQUENTIAL);
+		if (hash64(view.data(), view.size()) != dependency.hash)
+			return false;
+	}
+
+	return true;
+}
+
+std::string ModelData::params()
+{
+	std::stringstream params;
+	params << "model;v" << formatVersion << ";flags=" << importFlags;
+	return params.str();
+}
+
+void ModelData::processNode(aiNode* node, const aiScene* scene, const std::filesystem::path& baseDir)
+{
+	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	{
+		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+		processMesh(mesh, scene, baseDir);
+	}
+
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+		processNode(node->mChildren[i], scene, baseDir);
+}
+
+void ModelData::processMesh(aiMesh* mesh, const aiScene* scene, const std::filesystem::path& baseDir)
+{
+	MeshData meshData;
+
+	getVertices(meshData.vertices, mesh);
+	getIndices(meshData.indices, mesh);
+	getTextures(meshData.textures, mesh, scene, baseDir);
+
+	meshes.push_back(std::move(meshData));
+}
+
+void ModelData::getVertices(std::vector<Vertex>& vertices, aiMesh* mesh)
+{
+	vertices.reserve(mesh->mNumVertices);
+
+	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	{
+		// value initialized, so attributes missing in the mesh are zero
+		// and the cooked output is reproducible
+		Vertex vertex{};
+
+		if (mesh->HasPositions())
+		{
+			vertex.position.x = mesh->mVertices[i].x;
+			vertex.position.y = mesh->mVertices[i].y;
+			vertex.position.z = mesh->mVertices[i].z;
+		}
+
+		if (mesh->HasNormals())
+		{
+			vertex.normal.x = mesh->mNormals[i].x;
+			vertex.normal.y = mesh->mNormals[i].y;
+			vertex.normal.z = mesh->mNormals[i].z;
+		}
+
+		if (mesh->HasTextureCoords(0))
+		{
+			vertex.texCoords.x = mesh->mTextureCoords[0][i].x;
+			vertex.texCoords.y = mesh->mTextureCoords[0][i].y;
+		}
+
+		vertices.push_back(vertex);
+	}
+}
+
+void ModelData::getIndices(std::vector<GLuint>& indices, aiMesh* mesh)
+{
+	// faces are triangulated
+	indices.reserve(mesh->mNumFaces * 3);
+
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+	{
+		aiFace face = mesh->mFaces[i];
+
+		for (unsigned int j = 0; j < face.mNumIndices; j++)
+			indices.push_back(face.mIndices[j]);
+	}
+}
+
+void ModelData::getTextures(std::vector<TextureRef>& textures,
+	aiMesh* mesh, const aiScene* scene, const std::filesystem::path& baseDir
+)
+{
+	if (mesh->mMaterialIndex == 0)
+		return;
+
+	aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+
+	std::vector<std::pair<aiTextureType, std::string>> textureTypes = {
+		{ aiTextureType_DIFFUSE, "texture_diffuse" },
+		{ aiTextureType_SPECULAR, "texture_specular" },
+		{ aiTextureType_HEIGHT, "texture_normal" },
+		{ aiTextureType_AMBIENT, "texture_height" }
+	};
+
+	for (const std::pair<aiTextureType, std::string>& textureType : textureTypes)
+	{
+		for (unsigned int i = 0; i < material->GetTextureCount(textureType.first); i++)
+		{
+			aiString str;
+			material->GetTexture(textureType.first, i, &str);
+			std::filesystem::path path = baseDir / str.C_Str();
+
+			textures.push_back({ AssetPack::normalize(path), textureType.second });
+		}
+	}
+}
@@ -0,0 +1,310 @@
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+#include "profiler.h"
+#include "textRenderer.h"
+#include "shader.h"
+#include "trace.h"
+#include "glStatistics.h"
+
+
+bool Profiler::enabled = false;
+bool Profiler::frameOpen = false;
+bool Profiler::timerQueries = false;
+
+Profiler::Frame Profiler::frames[frameLatency];
+std::size_t Profiler::frame = 0;
+
+std::vector<std::size_t> Profiler::stack;
+
+std::vector<Profiler::History> Profiler::scopes;
+std::unordered_map<std::string, std::uint32_t> Profiler::scopeIndices;
+std::string Profiler::path;
+
+Profiler::Scope::Scope(const char* name)
+	: active{ enabled }
+{
+	// profiled scopes are part of the trace, whether profiling or not
+#ifdef APP_ENABLE_TRACING
+	Trace::begin(name);
+#endif
+
+	if (active)
+		beginScope(name);
+}
+
+Profiler::Scope::~Scope()
+{
+	if (active)
+		endScope();
+
+#ifdef APP_ENABLE_TRACING
+	Trace::end();
+#endif
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	if (Profiler::enabled == enabled)
+		return;
+
+	Profiler::enabled = enabled;
+
+	// the frame measured so far is incomplete, it is discarded
+	for (Frame& frame : frames)
+	{
+		frame.records.clear();
+		frame.queryCount = 0;
+	}
+
+	stack.clear();
+	path.clear();
+	frameOpen = false;
+}
+
+bool Profiler::isEnabled()
+{
+	return enabled;
+}
+
+void Profiler::beginScope(const char* name)
+{
+	if (!enabled)
+		return;
+
+	if (!frameOpen)
+		beginFrame();
+
+	if (!path.empty())
+		path += '/';
+	path += name;
+
+	auto [it, inserted] = scopeIndices.try_emplace(path, static_cast<std::uint32_t>(scopes.size()));
+	if (inserted)
+		scopes.push_back({ name, static_cast<int>(stack.size()), {}, {} });
+
+	Frame& current = frames[frame];
+	current.records.push_back({ it->second, Clock::now(), {}, timestamp(current), 0 });
+	stack.push_back(current.records.size() - 1);
+}
+
+void Profiler::endScope()
+{
+	// the root scope is only ended by endFrame()
+	if (!enabled || stack.size() <= 1)
+		return;
+
+	Frame& current = frames[frame];
+	Record& record = current.records[stack.back()];
+
+	record.endQuery = timestamp(current);
+	record.end = Clock::now();
+
+	stack.pop_back();
+	path.erase(std::min(path.size(), path.rfind('/')));
+}
+
+void Profiler::endFrame()
+{
+	if (!enabled)
+		return;
+
+	if (!frameOpen)
+		beginFrame();
+
+	// scopes still open end with the frame
+	while (stack.size() > 1)
+		endScope();
+
+	Frame& current = frames[frame];
+	Record& root = current.records[stack.back()];
+	root.endQuery = timestamp(current);
+	root.end = Clock::now();
+
+	stack.clear();
+	path.clear();
+	frameOpen = false;
+
+	// CPU times are known right away
+	for (const Record& record : current.records)
+	{
+		History& history = scopes[record.scope];
+		float milliseconds = std::chrono::duration<float, std::milli>(record.end - record.begin).count();
+		addSample(history.cpu, history.cpuNext, milliseconds);
+	}
+
+	// the next slot holds the oldest frame, its queries are reused now
+	frame = (frame + 1) % frameLatency;
+	readBack(frames[frame]);
+}
+
+std::vector<Profiler::Statistics> Profiler::getStatistics()
+{
+	std::vector<Statistics> statistics;
+	statistics.reserve(scopes.size());
+
+	for (const History& history : scopes)
+	{
+		statistics.push_back({
+			history.name,
+			history.depth,
+			history.cpu.size(),
+			history.gpu.size(),
+			getTiming(history.cpu),
+			getTiming(history.gpu)
+		});
+	}
+
+	return statistics;
+}
+
+void Profiler::printStatistics(std::ostream& stream)
+{
+	stream << std::fixed << std::setprecision(2);
+
+	for (const Statistics& scope : getStatistics())
+	{
+		stream
+			<< "Info: Profiler: " << std::string(scope.depth * 2, ' ') << scope.name << ": cpu "
+			<< scope.cpu.min << "/" << scope.cpu.p50 << "/" << scope.cpu.p99 << "/" << scope.cpu.max << " ms, gpu "
+			<< scope.gpu.min << "/" << scope.gpu.p50 << "/" << scope.gpu.p99 << "/" << scope.gpu.max
+			<< " ms (min/p50/p99/max over " << scope.cpuSamples << " frames)" << std::endl;
+	}
+
+	stream << std::defaultfloat;
+}
+
+void Profiler::renderOverlay(TextRenderer& textRenderer, Shader& shader, float x, float y)
+{
+	std::vector<Statistics> statistics = getStatistics();
+	if (statistics.empty())
+		return;
+
+	float lineHeight = textRenderer.getMaxCharHeight() * 1.25f;
+
+	// the font is expected to be monospaced, so the columns line up
+	std::size_t nameWidth = 5;
+	for (const Statistics& scope : statistics)
+		nameWidth = std::max(nameWidth, scope.name.size() + scope.depth * 2);
+	if (GLStatistics::isInstalled())
+		nameWidth = std::max<std::size_t>(nameWidth, 17);
+
+	std::stringstream line;
+	line << std::left << std::setw(nameWidth) << "scope" << std::right
+		<< "   cpu p50    p99    max   gpu p50    p99    max";
+
+	y += lineHeight;
+	textRenderer.renderText(shader, line.str(), x, y, TextRenderer::TOP_LEFT, glm::vec3(1.0f));
+
+	for (const Statistics& scope : statistics)
+	{
+		line.str("");
+		line
+			<< std::left << std::setw(nameWidth) << (std::string(scope.depth * 2, ' ') + scope.name) << std::right
+			<< std::fixed << std::setprecision(2)
+			<< std::setw(10) << scope.cpu.p50 << std::setw(7) << scope.cpu.p99 << std::setw(7) << scope.cpu.max
+			<< std::setw(10) << scope.gpu.p50 << std::setw(7) << scope.gpu.p99 << std::setw(7) << scope.gpu.max;
+
+		y += lineHeight;
+		textRenderer.renderText(shader, line.str(), x, y, TextRenderer::TOP_LEFT, glm::vec3(1.0f));
+	}
+
+	// OpenGL calls of the last frame, below the scopes
+	if (GLStatistics::isInstalled())
+	{
+		const GLStatistics::Counters& counters = GLStatistics::getLastFrame();
+		y += lineHeight;
+
+		for (int counter = 0; counter < GLStatistics::COUNTER_COUNT; counter++)
+		{
+			line.str("");
+			line << std::left << std::setw(nameWidth) << GLStatistics::toString(static_cast<GLStatistics::Counter>(counter))
+				<< std::right << std::setw(10) << counters[counter];
+
+			y += lineHeight;
+			textRenderer.renderText(shader, line.str(), x, y, TextRenderer::TOP_LEFT, glm::vec3(1.0f));
+		}
+	}
+}
+
+void Profiler::beginFrame()
+{
+	// timestamp queries are core since OpenGL 3.3
+	timerQueries = GLEW_ARB_timer_query || GLEW_VERSION_3_3;
+
+	frameOpen = true;
+	path.clear();
+	beginScope("frame");
+}
+
+void Profiler::readBack(Frame& frame)
+{
+	// the last query of the frame is available last
+	if (!frame.records.empty() && timerQueries)
+	{
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(frame.records.front().endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available == GL_TRUE)
+		{
+			for (const Record& record : frame.records)
+			{
+				GLuint64 begin = 0;
+				GLuint64 end = 0;
+				glGetQueryObjectui64v(record.beginQuery, GL_QUERY_RESULT, &begin);
+				glGetQueryObjectui64v(record.endQuery, GL_QUERY_RESULT, &end);
+
+				History& history = scopes[record.scope];
+				addSample(history.gpu, history.gpuNext, static_cast<float>(end - begin) / 1.0e6f);
+			}
+		}
+	}
+
+	frame.records.clear();
+	frame.queryCount = 0;
+}
+
+GLuint Profiler::timestamp(Frame& frame)
+{
+	if (!timerQueries)
+		return 0;
+
+	if (frame.queryCount == frame.queries.size())
+	{
+		GLuint query;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+	}
+
+	GLuint query = frame.queries[frame.queryCount++];
+	glQueryCounter(query, GL_TIMESTAMP);
+
+	return query;
+}
+
+void Profiler::addSample(std::vector<float>& samples, std::size_t& next, float sample)
+{
+	if (samples.size() < historySize)
+		samples.push_back(sample);
+	else
+		samples[next] = sample;
+
+	next = (next + 1) % historySize;
+}
+
+Profiler::Timing Profiler::getTiming(const std::vector<float>& samples)
+{
+	if (samples.empty())
+		return { 0.0, 0.0, 0.0, 0.0 };
+
+	std::vector<float> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+
+	auto percentile = [&](double p)
+	{
+		return static_cast<double>(sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()))]);
+	};
+
+	return { sorted.front(), sorted.back(), percentile(0.5), percentile(0.99) };
+}
@@ -1,8 +1,16 @@
-#include <fstream>
+#include <cstring>
 #include <sstream>
 #include <memory>
+#include <vector>
+#include <optional>
+#include <algorithm>
 
 #include "shader.h"
+#include "derivedDataCache.h"
+#include "assets.h"
+#include "trace.h"
+#include "startupReport.h"
+#include "allocationTracker.h"
 
 
 static_assert(
@@ -15,22 +23,9 @@ Shader::Shader(
 )
 	: program{ 0 }
 {
-	program = glCreateProgram();
-	try
-	{
-		compileShader(computeShaderPath, GL_COMPUTE_SHADER);
-		linkProgram();
-	}
-	catch (const std::ifstream::failure&)
-	{
-		deleteProgram();
-		throw;
-	}
-	catch (const std::runtime_error&)
-	{
-		deleteProgram();
-		throw;
-	}
+	createProgram({
+		{ computeShaderPath, GL_COMPUTE_SHADER }
+	});
 }
 
 Shader::Shader(
@@ -39,23 +34,10 @@ Shader::Shader(
 )
 	: program{ 0 }
 {
-	program = glCreateProgram();
-	try
-	{
-		compileShader(vertexShaderPath, GL_VERTEX_SHADER);
-		compileShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
-		linkProgram();
-	}
-	catch (const std::ifstream::failure&)
-	{
-		deleteProgram();
-		throw;
-	}
-	catch (const std::runtime_error&)
-	{
-		deleteProgram();
-		throw;
-	}
+	createProgram({
+		{ vertexShaderPath, GL_VERTEX_SHADER },
+		{ fragmentShaderPath, GL_FRAGMENT_SHADER }
+	});
 }
 
 Shader::Shader(
@@ -65,24 +47,11 @@ Shader::Shader(
 )
 	: program{ 0 }
 {
-	program = glCreateProgram();
-	try
-	{
-		compileShader(vertexShaderPath, GL_VERTEX_SHADER);
-		compileShader(geometryShaderPath, GL_GEOMETRY_SHADER);
-		compileShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
-		linkProgram();
-	}
-	catch (const std::ifstream::failure&)
-	{
-		deleteProgram();
-		throw;
-	}
-	catch (const std::runtime_error&)
-	{
-		deleteProgram();
-		throw;
-	}
+	createProgram({
+		{ vertexShaderPath, GL_VERTEX_SHADER },
+		{ geometryShaderPath, GL_GEOMETRY_SHADER },
+		{ fragmentShaderPath, GL_FRAGMENT_SHADER }
+	});
 }
 
 Shader::Shader(
@@ -93,25 +62,12 @@ Shader::Shader(
 )
 	: program{ 0 }
 {
-	program = glCreateProgram();
-	try
-	{
-		compileShader(vertexShaderPath, GL_VERTEX_SHADER);
-		compileShader(tessCtrlShaderPath, GL_TESS_CONTROL_SHADER);
-		compileShader(tessEvalShaderPath, GL_TESS_EVALUATION_SHADER);
-		compileShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
-		linkProgram();
-	}
-	catch (const std::ifstream::failure&)
-	{
-		deleteProgram();
-		throw;
-	}
-	catch (const std::runtime_error&)
-	{
-		deleteProgram();
-		throw;
-	}
+	createProgram({
+		{ vertexShaderPath, GL_VERTEX_SHADER },
+		{ tessCtrlShaderPath, GL_TESS_CONTROL_SHADER },
+		{ tessEvalShaderPath, GL_TESS_EVALUATION_SHADER },
+		{ fragmentShaderPath, GL_FRAGMENT_SHADER }
+	});
 }
 
 Shader::Shader(
@@ -123,30 +79,18 @@ Shader::Shader(
 )
 	: program{ 0 }
 {
-	program = glCreateProgram();
-	try
-	{
-		compileShader(vertexShaderPath, GL_VERTEX_SHADER);
-		compileShader(tessCtrlShaderPath, GL_TESS_CONTROL_SHADER);
-		compileShader(tessEvalShaderPath, GL_TESS_EVALUATION_SHADER);
-		compileShader(geometryShaderPath, GL_GEOMETRY_SHADER);
-		compileShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
-		linkProgram();
-	}
-	catch (const std::ifstream::failure&)
-	{
-		deleteProgram();
-		throw;
-	}
-	catch (const std::runtime_error&)
-	{
-		deleteProgram();
-		throw;
-	}
+	createProgram({
+		{ vertexShaderPath, GL_VERTEX_SHADER },
+		{ tessCtrlShaderPath, GL_TESS_CONTROL_SHADER },
+		{ tessEvalShaderPath, GL_TESS_EVALUATION_SHADER },
+		{ geometryShaderPath, GL_GEOMETRY_SHADER },
+		{ fragmentShaderPath, GL_FRAGMENT_SHADER }
+	});
 }
 
 Shader::Shader(Shader&& other) noexcept
 	: program{ other.program }
+	, uniformLocations{ std::move(other.uniformLocations) }
 {
 	other.program = 0;
 }
@@ -162,6 +106,7 @@ Shader& Shader::operator=(Shader&& other) noexcept
 	{
 		deleteProgram();
 		program = other.program;
+		uniformLocations = std::move(other.uniformLocations);
 		other.program = 0;
 	}
 
@@ -173,205 +118,382 @@ void Shader::useProgram()
 	glUseProgram(program);
 }
 
-void Shader::setUniform1f(const std::string& uniformName, GLfloat v0)
+GLint Shader::getUniformLocation(std::string_view uniformName)
+{
+	auto it = uniformLocations.find(uniformName);
+	if (it != uniformLocations.end())
+		return it->second;
+
+	// unknown names (-1) are cached as well, setting them does nothing
+	std::string name(uniformName);
+	GLint location = glGetUniformLocation(program, name.c_str());
+	uniformLocations.emplace(std::move(name), location);
+
+	return location;
+}
+
+GLint Shader::findUniformLocation(std::string_view uniformName) const
+{
+	auto it = uniformLocations.find(uniformName);
+	if (it != uniformLocations.end())
+		return it->second;
+
+	// glGetUniformLocation() needs a terminated string
+	char name[256];
+	if (uniformName.size() >= sizeof(name))
+		return -1;
+
+	uniformName.copy(name, uniformName.size());
+	name[uniformName.size()] = '\0';
+
+	return glGetUniformLocation(program, name);
+}
+
+GLuint Shader::getProgram() const
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	return program;
+}
+
+void Shader::setUniform1f(std::string_view uniformName, GLfloat v0)
+{
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform1f(uniformLocation, v0);
 }
 
-void Shader::setUniform2f(const std::string& uniformName, GLfloat v0, GLfloat v1)
+void Shader::setUniform2f(std::string_view uniformName, GLfloat v0, GLfloat v1)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform2f(uniformLocation, v0, v1);
 }
 
-void Shader::setUniform3f(const std::string& uniformName, GLfloat v0, GLfloat v1, GLfloat v2)
+void Shader::setUniform3f(std::string_view uniformName, GLfloat v0, GLfloat v1, GLfloat v2)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform3f(uniformLocation, v0, v1, v2);
 }
 
-void Shader::setUniform4f(const std::string& uniformName, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+void Shader::setUniform4f(std::string_view uniformName, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());	
+	GLint uniformLocation = getUniformLocation(uniformName);	
 	glUniform4f(uniformLocation, v0, v1, v2, v3);
 }
 
-void Shader::setUniform1i(const std::string& uniformName, GLint v0)
+void Shader::setUniform1i(std::string_view uniformName, GLint v0)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform1i(uniformLocation, v0);
 }
 
-void Shader::setUniform2i(const std::string& uniformName, GLint v0, GLint v1)
+void Shader::setUniform2i(std::string_view uniformName, GLint v0, GLint v1)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform2i(uniformLocation, v0, v1);
 }
 
-void Shader::setUniform3i(const std::string& uniformName, GLint v0, GLint v1, GLint v2)
+void Shader::setUniform3i(std::string_view uniformName, GLint v0, GLint v1, GLint v2)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform3i(uniformLocation, v0, v1, v2);
 }
 
-void Shader::setUniform4i(const std::string& uniformName, GLint v0, GLint v1, GLint v2, GLint v3)
+void Shader::setUniform4i(std::string_view uniformName, GLint v0, GLint v1, GLint v2, GLint v3)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform4i(uniformLocation, v0, v1, v2, v3);
 }
 
-void Shader::setUniform1ui(const std::string& uniformName, GLuint v0)
+void Shader::setUniform1ui(std::string_view uniformName, GLuint v0)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform1ui(uniformLocation, v0);
 }
 
-void Shader::setUniform2ui(const std::string& uniformName, GLuint v0, GLuint v1)
+void Shader::setUniform2ui(std::string_view uniformName, GLuint v0, GLuint v1)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform2ui(uniformLocation, v0, v1);
 }
 
-void Shader::setUniform3ui(const std::string& uniformName, GLuint v0, GLuint v1, GLuint v2)
+void Shader::setUniform3ui(std::string_view uniformName, GLuint v0, GLuint v1, GLuint v2)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform3ui(uniformLocation, v0, v1, v2);
 }
 
-void Shader::setUniform4ui(const std::string& uniformName, GLuint v0, GLuint v1, GLuint v2, GLuint v3)
+void Shader::setUniform4ui(std::string_view uniformName, GLuint v0, GLuint v1, GLuint v2, GLuint v3)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform4ui(uniformLocation, v0, v1, v2, v3);
 }
 
-void Shader::setUniform1fv(const std::string& uniformName, const GLfloat* value, GLsizei count)
+void Shader::setUniform1fv(std::string_view uniformName, const GLfloat* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform1fv(uniformLocation, count, value);
 }
 
-void Shader::setUniform2fv(const std::string& uniformName, const GLfloat* value, GLsizei count)
+void Shader::setUniform2fv(std::string_view uniformName, const GLfloat* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform2fv(uniformLocation, count, value);
 }
 
-void Shader::setUniform3fv(const std::string& uniformName, const GLfloat* value, GLsizei count)
+void Shader::setUniform3fv(std::string_view uniformName, const GLfloat* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform3fv(uniformLocation, count, value);
 }
 
-void Shader::setUniform4fv(const std::string& uniformName, const GLfloat* value, GLsizei count)
+void Shader::setUniform4fv(std::string_view uniformName, const GLfloat* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform4fv(uniformLocation, count, value);
 }
 
-void Shader::setUniform1iv(const std::string& uniformName, const GLint* value, GLsizei count)
+void Shader::setUniform1iv(std::string_view uniformName, const GLint* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform1iv(uniformLocation, count, value);
 }
 
-void Shader::setUniform2iv(const std::string& uniformName, const GLint* value, GLsizei count)
+void Shader::setUniform2iv(std::string_view uniformName, const GLint* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform2iv(uniformLocation, count, value);
 }
 
-void Shader::setUniform3iv(const std::string& uniformName, const GLint* value, GLsizei count)
+void Shader::setUniform3iv(std::string_view uniformName, const GLint* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform3iv(uniformLocation, count, value);
 }
 
-void Shader::setUniform4iv(const std::string& uniformName, const GLint* value, GLsizei count)
+void Shader::setUniform4iv(std::string_view uniformName, const GLint* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform4iv(uniformLocation, count, value);
 }
 
-void Shader::setUniform1uiv(const std::string& uniformName, const GLuint* value, GLsizei count)
+void Shader::setUniform1uiv(std::string_view uniformName, const GLuint* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform1uiv(uniformLocation, count, value);
 }
 
-void Shader::setUniform2uiv(const std::string& uniformName, const GLuint* value, GLsizei count)
+void Shader::setUniform2uiv(std::string_view uniformName, const GLuint* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform2uiv(uniformLocation, count, value);
 }
 
-void Shader::setUniform3uiv(const std::string& uniformName, const GLuint* value, GLsizei count)
+void Shader::setUniform3uiv(std::string_view uniformName, const GLuint* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform3uiv(uniformLocation, count, value);
 }
 
-void Shader::setUniform4uiv(const std::string& uniformName, const GLuint* value, GLsizei count)
+void Shader::setUniform4uiv(std::string_view uniformName, const GLuint* value, GLsizei count)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniform4uiv(uniformLocation, count, value);
 }
 
-void Shader::setUniformMatrix2fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix2fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix2fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::setUniformMatrix3fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix3fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix3fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::setUniformMatrix4fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix4fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix4fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::setUniformMatrix2x3fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix2x3fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix2x3fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::setUniformMatrix3x2fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix3x2fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix3x2fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::setUniformMatrix2x4fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix2x4fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix2x4fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::setUniformMatrix4x2fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix4x2fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix4x2fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::setUniformMatrix3x4fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix3x4fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix3x4fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::setUniformMatrix4x3fv(const std::string& uniformName, const GLfloat* value, GLsizei count, bool transpose)
+void Shader::setUniformMatrix4x3fv(std::string_view uniformName, const GLfloat* value, GLsizei count, bool transpose)
 {
-	GLint uniformLocation = glGetUniformLocation(program, uniformName.c_str());
+	GLint uniformLocation = getUniformLocation(uniformName);
 	glUniformMatrix4x3fv(uniformLocation, count, transpose, value);
 }
 
-void Shader::compileShader(const std::filesystem::path& shaderPath, GLenum shaderType)
+void Shader::createProgram(std::initializer_list<Stage> stages)
+{
+	TRACE_SCOPE("load shader", stages.begin()->path.string());
+	ALLOCATION_SCOPE("shader load");
+	StartupReport::AssetScope report("shader", stages.begin()->path, StartupReport::IO);
+
+	std::stringstream errorMessage;
+	errorMessage << "Error: Shader::createProgram(): ";
+
+	// map shader files, their sources are passed to the driver directly
+	// from the mappings without copying them into intermediate strings
+	std::vector<FileView> shaderFiles;
+
+	for (const Stage& stage : stages)
+	{
+		try { shaderFiles.push_back(Assets::open(stage.path, FileView::SEQUENTIAL)); }
+		catch (const std::runtime_error&)
+		{
+			errorMessage << "Reading file " << stage.path << " failed." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+	}
+
+	program = glCreateProgram();
+
+	// program binaries depend on the sources and the driver, a driver
+	// update invalidates them
+	std::uint64_t key = DerivedDataCache::key(shaderFiles, programBinaryParams());
+
+	// everything the driver does counts as upload, compiling and linking
+	// included
+	report.next(StartupReport::UPLOAD);
+
+	if (programBinarySupported() && loadProgramBinary(key))
+	{
+		cacheUniformLocations();
+		return;
+	}
+
+	try
+	{
+		std::size_t i = 0;
+		for (const Stage& stage : stages)
+			compileShader(shaderFiles[i++], stage.type);
+
+		if (programBinarySupported())
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		linkProgram();
+	}
+	catch (const std::runtime_error&)
+	{
+		deleteProgram();
+		throw;
+	}
+
+	cacheUniformLocations();
+
+	report.next(StartupReport::IO);
+	if (programBinarySupported())
+		storeProgramBinary(key);
+}
+
+bool Shader::programBinarySupported()
+{
+	static const bool supported = []()
+	{
+		if (!GLEW_ARB_get_program_binary)
+			return false;
+
+		GLint formatCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+		return formatCount > 0;
+	}();
+
+	return supported;
+}
+
+std::string Shader::programBinaryParams()
+{
+	auto glString = [](GLenum name)
+	{
+		const GLubyte* str = glGetString(name);
+		return str ? reinterpret_cast<const char*>(str) : "";
+	};
+
+	std::stringstream params;
+	params
+		<< "program v1;"
+		<< glString(GL_VENDOR) << ";"
+		<< glString(GL_RENDERER) << ";"
+		<< glString(GL_VERSION) << ";"
+		<< glString(GL_SHADING_LANGUAGE_VERSION);
+
+	return params.str();
+}
+
+bool Shader::loadProgramBinary(std::uint64_t key)
+{
+	std::optional<FileView> cached = DerivedDataCache::load(key, "program");
+	if (!cached || cached->size() <= sizeof(std::uint32_t))
+		return false;
+
+	std::uint32_t format;
+	std::memcpy(&format, cached->data(), sizeof(format));
+
+	glProgramBinary(
+		program, format,
+		cached->data() + sizeof(format),
+		static_cast<GLsizei>(cached->size() - sizeof(format))
+	);
+
+	// the driver may reject a binary even with matching params, in this
+	// case the program is compiled from source again
+	GLint success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+	return success;
+}
+
+void Shader::storeProgramBinary(std::uint64_t key)
+{
+	GLint binaryLen = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLen);
+
+	if (binaryLen <= 0)
+		return;
+
+	std::uint32_t format;
+	std::vector<std::byte> data(sizeof(format) + binaryLen);
+
+	GLenum binaryFormat;
+	glGetProgramBinary(program, binaryLen, nullptr, &binaryFormat, data.data() + sizeof(format));
+
+	format = binaryFormat;
+	std::memcpy(data.data(), &format, sizeof(format));
+
+	try { DerivedDataCache::store(key, "program", data); }
+	catch (const std::runtime_error&) {}
+}
+
+void Shader::compileShader(const FileView& shaderFile, GLenum shaderType)
 {
 	std::stringstream errorMessage;
 	std::string shaderTypeStr;
@@ -404,27 +526,9 @@ void Shader::compileShader(const std::filesystem::path& shaderPath, GLenum shade
 		throw std::runtime_error(errorMessage.str());
 	}
 
-	// open shader file and read its source
-	std::ifstream shaderFile;
-	std::stringstream shaderSourceSS;
-	std::string shaderSourceStr;
-	const GLchar* shaderSource;
-
-	shaderFile.exceptions(std::ifstream::badbit | std::ifstream::failbit);
-
-	try
-	{
-		shaderFile.open(shaderPath);
-		shaderSourceSS << shaderFile.rdbuf();
-		shaderFile.close();
-		shaderSourceStr = shaderSourceSS.str();
-		shaderSource = shaderSourceStr.c_str();
-	}
-	catch (const std::ifstream::failure&)
-	{
-		errorMessage << "Reading file " << shaderPath << " failed." << std::endl;
-		throw std::runtime_error(errorMessage.str());
-	}
+	// the mapping is not null-terminated, so the length is passed explicitly
+	const GLchar* shaderSource = reinterpret_cast<const GLchar*>(shaderFile.data());
+	GLint shaderSourceLen = static_cast<GLint>(shaderFile.size());
 
 	// compile shader
 	GLuint shader;
@@ -433,7 +537,7 @@ void Shader::compileShader(const std::filesystem::path& shaderPath, GLenum shade
 	std::unique_ptr<GLchar[]> infoLogBuf;
 
 	shader = glCreateShader(shaderType);
-	glShaderSource(shader, 1, &shaderSource, nullptr);
+	glShaderSource(shader, 1, &shaderSource, &shaderSourceLen);
 	glCompileShader(shader);
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 
@@ -446,7 +550,7 @@ void Shader::compileShader(const std::filesystem::path& shaderPath, GLenum shade
 		glDeleteShader(shader);
 		errorMessage
 			<< "Compilation of " << shaderTypeStr
-			<< " shader " << shaderPath << " failed with:" << std::endl
+			<< " shader " << shaderFile.getPath() << " failed with:" << std::endl
 			<< infoLogBuf << std::endl;
 		throw std::runtime_error(errorMessage.str());
 	}
@@ -480,7 +584,46 @@ void Shader::linkProgram()
 	}
 }
 
+void Shader::cacheUniformLocations()
+{
+	uniformLocations.clear();
+
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::string name;
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+
+		name.resize(std::max(maxNameLength, 1));
+		glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+		name.resize(length);
+
+		// uniforms of blocks have no location
+		GLint location = glGetUniformLocation(program, name.c_str());
+		if (location < 0)
+			continue;
+
+		// arrays are reported as name[0], they are set by name as well
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			uniformLocations.emplace(name.substr(0, name.size() - 3), location);
+
+		uniformLocations.emplace(name, location);
+	}
+}
+
 void Shader::deleteProgram()
 {
 	glDeleteProgram(program);
+	uniformLocations.clear();
+}
+
+std::size_t Shader::NameHash::operator()(std::string_view name) const
+{
+	return std::hash<std::string_view>{}(name);
 }
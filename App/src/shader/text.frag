@@ -1,12 +1,12 @@
 #version 420 core
 
-in vec2 texCoord;
+in vec3 texCoord;
+in vec4 color;
 out vec4 fragColor;
 
-uniform sampler2D texSampler;
-uniform vec3 texColor;
+uniform sampler2DArray texSampler;
 
 void main()
 {
-	fragColor = vec4(texColor, 1.0) * vec4(1.0, 1.0, 1.0, texture(texSampler, texCoord).r);
+	fragColor = color * vec4(1.0, 1.0, 1.0, texture(texSampler, texCoord).r);
 }
@@ -1,9 +1,11 @@
 #version 420 core
 
 layout (location = 0) in vec2 posAttrib;
-layout (location = 1) in vec2 texCoordAttrib;
+layout (location = 1) in vec3 texCoordAttrib;
+layout (location = 2) in vec4 colorAttrib;
 
-out vec2 texCoord;
+out vec3 texCoord;
+out vec4 color;
 
 uniform mat4 projection;
 
@@ -11,4 +13,5 @@ void main()
 {
 	gl_Position = projection * vec4(posAttrib, 0.0, 1.0);
 	texCoord = texCoordAttrib;
+	color = colorAttrib;
 }
@@ -0,0 +1,17 @@
+#version 420 core
+
+in vec3 texCoord;
+in vec4 color;
+out vec4 fragColor;
+
+uniform sampler2DArray texSampler;
+
+void main()
+{
+	// the outline is at distance 0.5; the edge is smoothed over about one
+	// pixel on screen, whatever size the glyph is drawn at
+	float distance = texture(texSampler, texCoord).r;
+	float width = 0.7 * fwidth(distance);
+
+	fragColor = color * vec4(1.0, 1.0, 1.0, smoothstep(0.5 - width, 0.5 + width, distance));
+}
@@ -0,0 +1,226 @@
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "startupReport.h"
+#include "json.h"
+
+
+const StartupReport::Clock::time_point StartupReport::startTime = StartupReport::Clock::now();
+StartupReport::Clock::time_point StartupReport::finishTime;
+std::atomic<bool> StartupReport::finished{ false };
+
+std::vector<StartupReport::PhaseRecord> StartupReport::phases;
+std::vector<std::size_t> StartupReport::openPhases;
+
+std::mutex StartupReport::mutex;
+std::vector<StartupReport::AssetRecord> StartupReport::assets;
+
+static const char* const stageNames[StartupReport::STAGE_COUNT] = { "io", "decode", "upload" };
+
+double StartupReport::AssetRecord::total() const
+{
+	double sum = 0.0;
+	for (double stageSeconds : seconds)
+		sum += stageSeconds;
+	return sum;
+}
+
+void StartupReport::beginPhase(const char* name)
+{
+	if (finished)
+		return;
+
+	openPhases.push_back(phases.size());
+	phases.push_back({ name, static_cast<int>(openPhases.size()) - 1, Clock::now(), {} });
+}
+
+void StartupReport::endPhase()
+{
+	if (finished || openPhases.empty())
+		return;
+
+	phases[openPhases.back()].end = Clock::now();
+	openPhases.pop_back();
+}
+
+StartupReport::Phase::Phase(const char* name)
+{
+	beginPhase(name);
+}
+
+StartupReport::Phase::~Phase()
+{
+	endPhase();
+}
+
+StartupReport::AssetScope::AssetScope(const char* kind, const std::filesystem::path& path, Stage stage)
+	: kind{ kind }
+	, path{ finished ? std::filesystem::path() : path }
+	, stage{ stage }
+	, begin{ Clock::now() }
+{
+
+}
+
+StartupReport::AssetScope::~AssetScope()
+{
+	if (!finished)
+		addAssetTime(kind, path, stage, std::chrono::duration<double>(Clock::now() - begin).count());
+}
+
+void StartupReport::AssetScope::next(Stage stage)
+{
+	if (finished || stage == this->stage)
+		return;
+
+	Clock::time_point now = Clock::now();
+	addAssetTime(kind, path, this->stage, std::chrono::duration<double>(now - begin).count());
+
+	this->stage = stage;
+	begin = now;
+}
+
+void StartupReport::finish()
+{
+	if (finished)
+		return;
+
+	while (!openPhases.empty())
+		endPhase();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	finishTime = Clock::now();
+	finished = true;
+}
+
+bool StartupReport::isFinished()
+{
+	return finished;
+}
+
+void StartupReport::print(std::ostream& stream)
+{
+	std::vector<AssetRecord> sorted = getSortedAssets();
+	Clock::time_point end = finished ? finishTime : Clock::now();
+
+	stream
+		<< std::fixed << std::setprecision(1)
+		<< "Info: StartupReport: " << milliseconds(startTime, end) << " ms to the first frame" << std::endl;
+
+	for (const PhaseRecord& phase : phases)
+	{
+		stream
+			<< "Info: StartupReport: " << std::string(phase.depth * 2, ' ')
+			<< std::left << std::setw(24 - phase.depth * 2) << phase.name << std::right
+			<< std::setw(10) << milliseconds(phase.begin, phase.end) << " ms (at "
+			<< milliseconds(startTime, phase.begin) << " ms)" << std::endl;
+	}
+
+	stream
+		<< "Info: StartupReport: " << std::setw(10) << "total ms" << std::setw(10) << "io"
+		<< std::setw(10) << "decode" << std::setw(10) << "upload" << "  asset" << std::endl;
+
+	for (const AssetRecord& asset : sorted)
+	{
+		stream
+			<< "Info: StartupReport: " << std::setw(10) << asset.total() * 1000.0
+			<< std::setw(10) << asset.seconds[IO] * 1000.0
+			<< std::setw(10) << asset.seconds[DECODE] * 1000.0
+			<< std::setw(10) << asset.seconds[UPLOAD] * 1000.0
+			<< "  " << asset.kind << " " << asset.path << std::endl;
+	}
+
+	stream << std::defaultfloat;
+}
+
+bool StartupReport::writeJson(const std::filesystem::path& path)
+{
+	std::vector<AssetRecord> sorted = getSortedAssets();
+	Clock::time_point end = finished ? finishTime : Clock::now();
+
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	file << std::fixed << std::setprecision(3)
+		<< "{\n\t\"first_frame_ms\": " << milliseconds(startTime, end) << ",\n\t\"phases\": [";
+
+	for (std::size_t i = 0; i < phases.size(); i++)
+	{
+		const PhaseRecord& phase = phases[i];
+
+		file << (i == 0 ? "\n" : ",\n") << "\t\t{\"name\": \"";
+		writeJsonEscaped(file, phase.name);
+		file
+			<< "\", \"depth\": " << phase.depth
+			<< ", \"start_ms\": " << milliseconds(startTime, phase.begin)
+			<< ", \"duration_ms\": " << milliseconds(phase.begin, phase.end) << "}";
+	}
+
+	file << "\n\t],\n\t\"assets\": [";
+
+	for (std::size_t i = 0; i < sorted.size(); i++)
+	{
+		const AssetRecord& asset = sorted[i];
+
+		file << (i == 0 ? "\n" : ",\n") << "\t\t{\"kind\": \"";
+		writeJsonEscaped(file, asset.kind);
+		file << "\", \"path\": \"";
+		writeJsonEscaped(file, asset.path);
+		file << "\", \"total_ms\": " << asset.total() * 1000.0;
+
+		for (int stage = 0; stage < STAGE_COUNT; stage++)
+			file << ", \"" << stageNames[stage] << "_ms\": " << asset.seconds[stage] * 1000.0;
+
+		file << "}";
+	}
+
+	file << "\n\t]\n}\n";
+
+	return static_cast<bool>(file);
+}
+
+void StartupReport::addAssetTime(const char* kind, const std::filesystem::path& path, Stage stage, double seconds)
+{
+	std::string assetPath = path.generic_string();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (finished)
+		return;
+
+	// a few dozen assets at startup, a linear search is fine
+	auto it = std::find_if(assets.begin(), assets.end(), [&](const AssetRecord& asset)
+	{
+		return asset.path == assetPath && asset.kind == kind;
+	});
+
+	if (it == assets.end())
+	{
+		assets.push_back({ kind, assetPath, {} });
+		it = assets.end() - 1;
+	}
+
+	it->seconds[stage] += seconds;
+}
+
+std::vector<StartupReport::AssetRecord> StartupReport::getSortedAssets()
+{
+	std::vector<AssetRecord> sorted;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		sorted = assets;
+	}
+
+	std::stable_sort(sorted.begin(), sorted.end(), [](const AssetRecord& a, const AssetRecord& b)
+	{
+		return a.total() > b.total();
+	});
+
+	return sorted;
+}
+
+double StartupReport::milliseconds(Clock::time_point begin, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - begin).count();
+}
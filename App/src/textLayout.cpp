@@ -0,0 +1,95 @@
+#include <utility>
+
+#include "textLayout.h"
+#include "glHandlePool.h"
+
+
+TextLayout::TextLayout()
+	: renderer{ nullptr }
+	, position{ glm::vec2(0.0f, 0.0f) }
+	, origin{ 0 }
+	, color{ glm::vec3(0.0f, 0.0f, 0.0f) }
+	, scale{ 0.0f }
+	, windowHeight{ 0 }
+	, evictionCount{ 0 }
+	, quadCount{ 0 }
+	, capacity{ 0 }
+	, shapeCount{ 0 }
+	, VAO{ 0 }
+	, VBO{ 0 }
+{
+
+}
+
+TextLayout::TextLayout(TextLayout&& other) noexcept
+	: renderer{ other.renderer }
+	, str{ std::move(other.str) }
+	, position{ other.position }
+	, origin{ other.origin }
+	, color{ other.color }
+	, scale{ other.scale }
+	, windowHeight{ other.windowHeight }
+	, evictionCount{ other.evictionCount }
+	, pages{ std::move(other.pages) }
+	, quadCount{ other.quadCount }
+	, capacity{ other.capacity }
+	, shapeCount{ other.shapeCount }
+	, VAO{ other.VAO }
+	, VBO{ other.VBO }
+	, gpuMemory{ std::move(other.gpuMemory) }
+{
+	other.renderer = nullptr;
+	other.quadCount = 0;
+	other.capacity = 0;
+	other.VAO = 0;
+	other.VBO = 0;
+}
+
+TextLayout::~TextLayout()
+{
+	deleteGLObjects();
+}
+
+TextLayout& TextLayout::operator=(TextLayout&& other) noexcept
+{
+	if (this != &other)
+	{
+		deleteGLObjects();
+
+		renderer = other.renderer;
+		str = std::move(other.str);
+		position = other.position;
+		origin = other.origin;
+		color = other.color;
+		scale = other.scale;
+		windowHeight = other.windowHeight;
+		evictionCount = other.evictionCount;
+		pages = std::move(other.pages);
+		quadCount = other.quadCount;
+		capacity = other.capacity;
+		shapeCount = other.shapeCount;
+		VAO = other.VAO;
+		VBO = other.VBO;
+		gpuMemory = std::move(other.gpuMemory);
+
+		other.renderer = nullptr;
+		other.quadCount = 0;
+		other.capacity = 0;
+		other.VAO = 0;
+		other.VBO = 0;
+	}
+
+	return *this;
+}
+
+unsigned int TextLayout::getShapeCount() const
+{
+	return shapeCount;
+}
+
+void TextLayout::deleteGLObjects()
+{
+	GLHandlePool::release(GLHandlePool::BUFFER, VBO);
+	GLHandlePool::release(GLHandlePool::VERTEX_ARRAY, VAO);
+	gpuMemory = GPUMemory::Allocation();
+}
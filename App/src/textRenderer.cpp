@@ -1,21 +1,36 @@
+#include <cmath>
+#include <cstddef>
 #include <iomanip>
+#include <iostream>
 #include <sstream>
+#include <optional>
 #include <algorithm>
+#include <string_view>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <ft2build.h>
-#include FT_FREETYPE_H
 
 #include "textRenderer.h"
+#include "fontData.h"
+#include "assets.h"
+#include "utf8.h"
+#include "glStatistics.h"
+#include "startupReport.h"
+#include "allocationTracker.h"
+#include "frameArena.h"
+#include "glHandlePool.h"
 
 
 TextRenderer::TextRenderer(
 	const std::filesystem::path& fontPath,
-	unsigned int width, unsigned int height
+	unsigned int width, unsigned int height,
+	FontData::Mode mode
 )
 	: window{ nullptr }
+	, mode{ mode }
+	, rasterSize{ mode == FontData::SDF ? glm::uvec2(0, FontData::sdfSize) : glm::uvec2(width, height) }
+	, glyphScale{ 1.0f }
 	, defaultSize{ glm::uvec2(width, height) }
 	, maxCharSize{ glm::uvec2(0, 0) }
 	, maxLetterSize{ glm::uvec2(0, 0) }
@@ -24,6 +39,11 @@ TextRenderer::TextRenderer(
 	, VAO{ 0 }
 	, VBO{ 0 }
 	, EBO{ 0 }
+	, mapping{ nullptr }
+	, fences{}
+	, region{ 0 }
+	, quadCount{ 0 }
+	, batchShader{ nullptr }
 {
 	std::stringstream errorMessage;
 	errorMessage << "Error: TextRenderer::TextRenderer(): ";
@@ -44,168 +64,169 @@ TextRenderer::TextRenderer(
 		throw std::runtime_error(errorMessage.str());
 	}
 
-	FT_Library lib;
-	if (FT_Init_FreeType(&lib))
-	{
-		errorMessage << "FT_Init_FreeType() failed." << std::endl;
-		throw std::runtime_error(errorMessage.str());
-	}
+	// FreeType reads the font directly from the mapping
+	fontFile = Assets::open(fontPath, FileView::RANDOM);
 
-	FT_Face face;
-	if (FT_New_Face(lib, fontPath.string().c_str(), 0, &face))
-	{
-		FT_Done_FreeType(lib);
-		errorMessage
-			<< "FT_New_Face() failed for font "
-			<< fontPath << "." << std::endl;
-		throw std::runtime_error(errorMessage.str());
-	}
+	// rasterized ASCII glyphs come from the cooker (or a previous run) when
+	// available, otherwise they are rasterized with FreeType now; SDF glyphs
+	// don't depend on the size, so all SDF renderers of a font share them
+	FontData::LoadInfo loadInfo;
+	FontData font = FontData::load(fontPath, rasterSize.x, rasterSize.y, mode, &loadInfo);
 
-	FT_Set_Pixel_Sizes(face, defaultSize.x, defaultSize.y);
+	std::cout << "Info: TextRenderer: " << fontPath.string() << ": " << loadInfo.glyphCount << " glyphs ";
+	if (loadInfo.cached)
+		std::cout << "loaded from cache";
+	else
+		std::cout << "rasterized on " << loadInfo.threadCount << (loadInfo.threadCount == 1 ? " thread" : " threads");
+	std::cout << " in " << std::fixed << std::setprecision(2) << loadInfo.seconds * 1000.0 << " ms" << std::defaultfloat << std::endl;
+
+	if (mode == FontData::SDF)
+		glyphScale = static_cast<GLfloat>(height != 0 ? height : width) / FontData::sdfSize;
 
 	// OpenGL options needed by FreeType
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	// FreeType only uses 1 byte per pixel (FT_PIXEL_MODE_GRAY) instead of 3 bytes (GL_RGB)
-	// therefore the alignment for pixel data has to be changed to 1
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-	// load first 128 characters of ASCII set
-	bool success = true;
-	for (unsigned int c = 0; c < 128; c++)
+	// all glyphs end up in a single texture, the printable ASCII glyphs
+	// are uploaded with it
 	{
-		// load character glyph 
-		if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-		{
-			success = false;
-			errorMessage
-				<< "FT_Load_Char() failed for char 0x"
-				<< std::setw(2) << std::setfill('0') << std::hex << c << "." << std::endl;
-			continue;
-		}
-
-		// texture begin
-		GLuint texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(
-			GL_TEXTURE_2D,
-			0,
-			GL_RED,
-			face->glyph->bitmap.width,
-			face->glyph->bitmap.rows,
-			0,
-			GL_RED,
-			GL_UNSIGNED_BYTE,
-			face->glyph->bitmap.buffer
-		);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		StartupReport::AssetScope report("font", fontPath, StartupReport::UPLOAD);
+		atlas = GlyphAtlas(glm::uvec2(atlasPageSize), atlasPageCount, font);
+	}
 
-		glBindTexture(GL_TEXTURE_2D, 0);
-		// texture end
+	// SDF metrics are reported without the border and at the default size
+	int border = mode == FontData::SDF ? FontData::sdfSpread : 0;
+	auto scaled = [this](int value) { return static_cast<int>(std::lround(value * glyphScale)); };
 
-		// store character for later use
-		Char ch =
-		{
-			texture,
-			glm::uvec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-			glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-			face->glyph->advance.x
-		};
+	for (unsigned int c = 0; c < font.glyphs.size(); c++)
+	{
+		const FontData::Glyph& glyph = font.glyphs[c];
 
-		chars.insert({ c, ch });
+		glm::uvec2 size(
+			scaled(std::max(static_cast<int>(glyph.size.x) - 2 * border, 0)),
+			scaled(std::max(static_cast<int>(glyph.size.y) - 2 * border, 0))
+		);
+		glm::ivec2 bearing(
+			scaled(glyph.bearing.x + border),
+			scaled(glyph.bearing.y - border)
+		);
 
 		// update max dimensions for...
 		// all chars
-		maxCharSize.x = std::max(maxCharSize.x, ch.size.x);
-		maxCharSize.y = std::max(maxCharSize.y, ch.size.y);
-		maxBearing.x = std::max(maxBearing.x, ch.bearing.x);
-		maxBearing.y = std::max(maxBearing.y, ch.bearing.y);
+		maxCharSize.x = std::max(maxCharSize.x, size.x);
+		maxCharSize.y = std::max(maxCharSize.y, size.y);
+		maxBearing.x = std::max(maxBearing.x, bearing.x);
+		maxBearing.y = std::max(maxBearing.y, bearing.y);
 
 		// numbers
 		if (c >= '0' && c <= '9')
 		{
-			maxNumberSize.x = std::max(maxNumberSize.x, ch.size.x);
-			maxNumberSize.y = std::max(maxNumberSize.y, ch.size.y);
+			maxNumberSize.x = std::max(maxNumberSize.x, size.x);
+			maxNumberSize.y = std::max(maxNumberSize.y, size.y);
 		}
 		// capitalized letters
 		else if (c >= 'A' && c <= 'Z')
 		{
-			maxLetterSize.x = std::max(maxLetterSize.x, ch.size.x);
-			maxLetterSize.y = std::max(maxLetterSize.y, ch.size.y);
+			maxLetterSize.x = std::max(maxLetterSize.x, size.x);
+			maxLetterSize.y = std::max(maxLetterSize.y, size.y);
 		}
 	}
 
-	FT_Done_Face(face);
-	FT_Done_FreeType(lib);
+	// index array, the same 6 indices for every quad of a region; the
+	// region is selected with the base vertex when drawing
+	std::vector<GLuint> indices(static_cast<std::size_t>(quadsPerRegion) * 6);
 
-	if (!success)
+	for (GLuint quad = 0; quad < static_cast<GLuint>(quadsPerRegion); quad++)
 	{
-		deleteGLObjects();
-		throw std::runtime_error(errorMessage.str());
+		GLuint* quadIndices = &indices[quad * 6];
+
+		quadIndices[0] = quad * 4 + 0;
+		quadIndices[1] = quad * 4 + 1;
+		quadIndices[2] = quad * 4 + 2;
+		quadIndices[3] = quad * 4 + 2;
+		quadIndices[4] = quad * 4 + 3;
+		quadIndices[5] = quad * 4 + 1;
 	}
 
-	// index array
-	GLuint indices[] =
-	{
-		0, 1, 2,
-		2, 3, 1
-	};
-
 // VAO begin
-	glGenVertexArrays(1, &VAO);
+	VAO = GLHandlePool::acquire(GLHandlePool::VERTEX_ARRAY);
 	glBindVertexArray(VAO);
 
-	// VBO begin
+	// VBO begin, not pooled, its storage may be immutable
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, 2 * 2 * 4 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
-	
-	glVertexAttribPointer(
-		0, 2, GL_FLOAT, GL_FALSE,
-		4 * sizeof(GLfloat), reinterpret_cast<void*>(0)
-	);
-	glEnableVertexAttribArray(0);
 
-	glVertexAttribPointer(
-		1, 2, GL_FLOAT, GL_FALSE,
-		4 * sizeof(GLfloat), reinterpret_cast<void*>(2 * sizeof(GLfloat))
-	);
-	glEnableVertexAttribArray(1);
+	if (GLEW_ARB_buffer_storage)
+	{
+		GLsizeiptr bufferSize = static_cast<GLsizeiptr>(regionCount) * quadsPerRegion * 4 * sizeof(Vertex);
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glBufferStorage(GL_ARRAY_BUFFER, bufferSize, nullptr, flags);
+		mapping = reinterpret_cast<Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, flags));
+	}
+
+	// the staging buffer holds one region, it is uploaded (and the buffer
+	// orphaned) on every flush
+	if (mapping == nullptr)
+	{
+		staging.resize(static_cast<std::size_t>(quadsPerRegion) * 4);
+		glBufferData(GL_ARRAY_BUFFER, staging.size() * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+	}
+
+	setupVertexAttributes();
 	// VBO end
 
 	// EBO begin
-	glGenBuffers(1, &EBO);
+	EBO = GLHandlePool::acquire(GLHandlePool::BUFFER);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 	// EBO end
 
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 // VAO end
+
+	GLsizeiptr vertexBytes = static_cast<GLsizeiptr>(mapping != nullptr ? regionCount : 1) * quadsPerRegion * 4 * sizeof(Vertex);
+	gpuMemory = GPUMemory::Allocation(GPUMemory::GLYPHS, vertexBytes + indices.size() * sizeof(GLuint));
 }
 
 TextRenderer::TextRenderer(TextRenderer&& other) noexcept
 	: window{ std::move(other.window) }
+	, mode{ other.mode }
+	, rasterSize{ other.rasterSize }
+	, glyphScale{ other.glyphScale }
 	, defaultSize{ other.defaultSize }
 	, maxCharSize{ other.maxCharSize }
 	, maxLetterSize{ other.maxLetterSize }
 	, maxNumberSize{ other.maxNumberSize }
 	, maxBearing{ other.maxBearing }
-	, chars{ std::move(other.chars) }
-	, VAO{ 0 }
-	, VBO{ 0 }
-	, EBO{ 0 }
+	, fontFile{ std::move(other.fontFile) }
+	, rasterizer{ std::move(other.rasterizer) }
+	, atlas{ std::move(other.atlas) }
+	, VAO{ other.VAO }
+	, VBO{ other.VBO }
+	, EBO{ other.EBO }
+	, gpuMemory{ std::move(other.gpuMemory) }
+	, mapping{ other.mapping }
+	, staging{ std::move(other.staging) }
+	, region{ other.region }
+	, quadCount{ other.quadCount }
+	, batchShader{ other.batchShader }
+	, layouts{ std::move(other.layouts) }
 {
+	for (GLsizei i = 0; i < regionCount; i++)
+	{
+		fences[i] = other.fences[i];
+		other.fences[i] = nullptr;
+	}
+
 	other.VAO = 0;
 	other.VBO = 0;
 	other.EBO = 0;
+	other.mapping = nullptr;
+	other.quadCount = 0;
+	other.batchShader = nullptr;
 }
 
 TextRenderer::~TextRenderer()
@@ -220,19 +241,40 @@ TextRenderer& TextRenderer::operator=(TextRenderer&& other) noexcept
 		deleteGLObjects();
 
 		window = std::move(other.window);
+		mode = other.mode;
+		rasterSize = other.rasterSize;
+		glyphScale = other.glyphScale;
 		defaultSize = other.defaultSize;
 		maxCharSize = other.maxCharSize;
 		maxLetterSize = other.maxLetterSize;
 		maxNumberSize = other.maxNumberSize;
 		maxBearing = other.maxBearing;
-		chars = std::move(other.chars);
+		fontFile = std::move(other.fontFile);
+		rasterizer = std::move(other.rasterizer);
+		atlas = std::move(other.atlas);
 		VAO = other.VAO;
 		VBO = other.VBO;
 		EBO = other.EBO;
+		gpuMemory = std::move(other.gpuMemory);
+		mapping = other.mapping;
+		staging = std::move(other.staging);
+		region = other.region;
+		quadCount = other.quadCount;
+		batchShader = other.batchShader;
+		layouts = std::move(other.layouts);
+
+		for (GLsizei i = 0; i < regionCount; i++)
+		{
+			fences[i] = other.fences[i];
+			other.fences[i] = nullptr;
+		}
 
 		other.VAO = 0;
 		other.VBO = 0;
 		other.EBO = 0;
+		other.mapping = nullptr;
+		other.quadCount = 0;
+		other.batchShader = nullptr;
 	}
 
 	return *this;
@@ -240,82 +282,386 @@ TextRenderer& TextRenderer::operator=(TextRenderer&& other) noexcept
 
 void TextRenderer::renderText(
 	Shader& shader,
-	const std::string& str,
+	std::string_view str,
 	float x, float y, Origin origin,
 	glm::vec3 color, float scale
 )
 {
+	ALLOCATION_SCOPE("text");
+
 	if (origin == TOP_LEFT)
 		y = window->getHeight() - y;
 
+	// a batch is drawn with a single shader
+	if (batchShader != &shader)
+		flush();
+
+	batchShader = &shader;
+
+	GLuint packedColor = packColor(color);
+
+	// iterate over all codepoints in str
+	for (std::size_t pos = 0; pos < str.size();)
+	{
+		// inserting a glyph may flush the batch
+		const GlyphAtlas::Glyph* ch = getGlyph(decodeUtf8(str, pos));
+		if (ch == nullptr)
+			continue;
+
+		// a full region is drawn right away
+		if (quadCount == quadsPerRegion)
+			flush();
+
+		batchShader = &shader;
+
+		shapeGlyph(*ch, x, y, scale, packedColor, getRegion() + quadCount * 4);
+		quadCount++;
+	}
+}
+
+void TextRenderer::renderText(
+	Shader& shader,
+	TextLayout& layout,
+	std::string_view str,
+	float x, float y, Origin origin,
+	glm::vec3 color, float scale
+)
+{
+	ALLOCATION_SCOPE("text");
+
+	int windowHeight = origin == TOP_LEFT ? window->getHeight() : 0;
+
+	if (layout.evictionCount == atlas.getEvictionCount() &&
+		layout.renderer == this &&
+		layout.str == str &&
+		layout.position == glm::vec2(x, y) &&
+		layout.origin == origin &&
+		layout.color == color &&
+		layout.scale == scale &&
+		layout.windowHeight == windowHeight)
+	{
+		// the glyphs are drawn without looking them up
+		for (GLuint page : layout.pages)
+			atlas.markUsed(page);
+
+		if (batchShader != &shader)
+			flush();
+
+		batchShader = &shader;
+		layouts.push_back(&layout);
+		return;
+	}
+
+	// the vertex array of a layout refers to the index buffer of the
+	// renderer it was first used with
+	if (layout.renderer != this)
+	{
+		layout.deleteGLObjects();
+		layout.VAO = 0;
+		layout.VBO = 0;
+		layout.capacity = 0;
+	}
+
+	layout.renderer = this;
+	layout.str = str;
+	layout.position = glm::vec2(x, y);
+	layout.origin = origin;
+	layout.color = color;
+	layout.scale = scale;
+	layout.windowHeight = windowHeight;
+	layout.shapeCount++;
+
+	if (origin == TOP_LEFT)
+		y = windowHeight - y;
+
+	GLuint packedColor = packColor(color);
+
+	// the quads are only needed until they are uploaded
+	FrameArena::Vector<Vertex> vertices(FrameArena::resource());
+	vertices.reserve(str.size() * 4);
+
+	// when a page is evicted while shaping, glyphs shaped before may have
+	// been on it, so the layout is shaped again; a second eviction means
+	// the string doesn't fit into the atlas, it is drawn incomplete then
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		layout.evictionCount = atlas.getEvictionCount();
+		layout.pages.clear();
+		vertices.clear();
+
+		GLfloat penX = x;
+		for (std::size_t pos = 0; pos < str.size();)
+		{
+			const GlyphAtlas::Glyph* ch = getGlyph(decodeUtf8(str, pos));
+			if (ch == nullptr)
+				continue;
+
+			if (std::find(layout.pages.begin(), layout.pages.end(), ch->page) == layout.pages.end())
+				layout.pages.push_back(ch->page);
+
+			vertices.resize(vertices.size() + 4);
+			shapeGlyph(*ch, penX, y, scale, packedColor, vertices.data() + vertices.size() - 4);
+		}
+
+		if (layout.evictionCount == atlas.getEvictionCount())
+			break;
+	}
+
+	layout.quadCount = static_cast<GLsizei>(vertices.size() / 4);
+
+	// the layout's vertex array uses the index buffer of the renderer
+	if (layout.VAO == 0)
+	{
+		layout.VAO = GLHandlePool::acquire(GLHandlePool::VERTEX_ARRAY);
+		glBindVertexArray(layout.VAO);
+
+		layout.VBO = GLHandlePool::acquire(GLHandlePool::BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, layout.VBO);
+		setupVertexAttributes();
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+		glBindVertexArray(0);
+	}
+
+	GLsizeiptr size = vertices.size() * sizeof(Vertex);
+	glBindBuffer(GL_ARRAY_BUFFER, layout.VBO);
+
+	// the buffer only grows, shorter strings are uploaded into it
+	if (size > layout.capacity)
+	{
+		glBufferData(GL_ARRAY_BUFFER, size, vertices.data(), GL_DYNAMIC_DRAW);
+		layout.capacity = size;
+		layout.gpuMemory = GPUMemory::Allocation(GPUMemory::GLYPHS, size);
+	}
+	else if (size > 0)
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices.data());
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (batchShader != &shader)
+		flush();
+
+	batchShader = &shader;
+	layouts.push_back(&layout);
+}
+
+void TextRenderer::flush()
+{
+	// everything drawn was shaped and uploaded before
+	ALLOCATION_HOT_SCOPE("text flush");
+
+	if ((quadCount == 0 && layouts.empty()) || batchShader == nullptr)
+		return;
+
 	glViewport(0, 0, window->getWidth(), window->getHeight());
 
 	// set active shader
-	shader.useProgram();
+	batchShader->useProgram();
 
 	// set projection matrix in current shader
 	glm::mat4 projection = glm::ortho<GLfloat>(
 		0.0f, static_cast<GLfloat>(window->getWidth()),
 		0.0f, static_cast<GLfloat>(window->getHeight())
 	);
-	shader.setUniformMatrix4fv("projection", glm::value_ptr<GLfloat>(projection));
+	batchShader->setUniformMatrix4fv("projection", glm::value_ptr<GLfloat>(projection));
 
-	// set textColor in current shader
-	shader.setUniform3f("texColor", color.x, color.y, color.z);
-	
-	// bind current vertex array
+	// bind current vertex array and the atlas, which holds all glyphs
 	glBindVertexArray(VAO);
-	
-	// iterate over all chars in str
-	for (const char& c : str)
+	glBindTexture(GL_TEXTURE_2D_ARRAY, atlas.getTexture());
+	GLStatistics::count(GLStatistics::STATE_CHANGES);
+
+	if (quadCount > 0)
 	{
-		Char ch;
+		GLint baseVertex = 0;
 
-		// skip non-printable chars
-		if (c < 32 || c > 126)
-			continue;
-		// when the current char was not loaded or is not available, '?' is rendered instead
-		else if (chars.find(c) == chars.end())
-			ch = chars.at('?');
+		if (mapping != nullptr)
+		{
+			// the mapping is coherent, the written quads are visible to the
+			// GPU without flushing them explicitly
+			baseVertex = region * quadsPerRegion * 4;
+		}
 		else
-			ch = chars.at(c);
+		{
+			// orphan the buffer, so the upload doesn't wait for previous draws
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBufferData(GL_ARRAY_BUFFER, staging.size() * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, quadCount * 4 * sizeof(Vertex), staging.data());
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		// draw all glyphs
+		glDrawElementsBaseVertex(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_INT, 0, baseVertex);
 
-		GLfloat xPos = x + ch.bearing.x * scale;
-		GLfloat yPos = y - (ch.size.y - ch.bearing.y) * scale;
+		if (mapping != nullptr)
+		{
+			fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			region = (region + 1) % regionCount;
+		}
+	}
 
-		GLfloat w = ch.size.x * scale;
-		GLfloat h = ch.size.y * scale;
+	// cached layouts are drawn from their own buffers; the index buffer
+	// covers a region, longer layouts are drawn in several parts
+	for (TextLayout* layout : layouts)
+	{
+		glBindVertexArray(layout->VAO);
 
-		// vertex array
-		GLfloat vertices[] =
+		for (GLsizei first = 0; first < layout->quadCount; first += quadsPerRegion)
 		{
-			// positions		// texture coordinates
-			xPos,     yPos,		0.0f, 1.0f,	// top left
-			xPos + w, yPos,		1.0f, 1.0f,	// top right
-			xPos,     yPos + h,	0.0f, 0.0f,	// bottom left
-			xPos + w, yPos + h,	1.0f, 0.0f	// bottom right
-		};
-
-		// copy vertex array into the OpenGL vertex buffer created previously
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-		// bind current texture object
-		glBindTexture(GL_TEXTURE_2D, ch.texture);
-		
-		// draw glyph
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-		// unbind texture object
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		// move cursors to next glyph
-		x += (ch.advance >> 6) * scale; // advance is measured in 1/64 pixels, divide by 64 to get advance in pixels
+			GLsizei count = std::min(layout->quadCount - first, quadsPerRegion);
+			glDrawElementsBaseVertex(GL_TRIANGLES, count * 6, GL_UNSIGNED_INT, 0, first * 4);
+		}
 	}
 
-	// unbind vertex array object
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 	glBindVertexArray(0);
+
+	quadCount = 0;
+	layouts.clear();
+	batchShader = nullptr;
+}
+
+void TextRenderer::endFrame()
+{
+	flush();
+	atlas.nextFrame();
+}
+
+TextRenderer::Vertex* TextRenderer::getRegion()
+{
+	if (mapping == nullptr)
+		return staging.data();
+
+	// the GPU has to be done reading the region before it is overwritten;
+	// with 3 regions this only waits when the GPU is frames behind
+	if (fences[region] != nullptr)
+	{
+		while (glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+
+		glDeleteSync(fences[region]);
+		fences[region] = nullptr;
+	}
+
+	return mapping + region * quadsPerRegion * 4;
+}
+
+const GlyphAtlas::Glyph* TextRenderer::getGlyph(char32_t codepoint)
+{
+	// skip control chars
+	if (codepoint < 0x20 || (codepoint >= 0x7F && codepoint < 0xA0))
+		return nullptr;
+
+	const GlyphAtlas::Glyph* glyph;
+
+	switch (atlas.lookup(codepoint, glyph))
+	{
+	case GlyphAtlas::RESIDENT:
+		return glyph;
+	case GlyphAtlas::UNKNOWN:
+		glyph = insertGlyph(codepoint);
+		if (glyph != nullptr)
+			return glyph;
+		break;
+	case GlyphAtlas::MISSING:
+		break;
+	}
+
+	// when a char is not available, '?' is rendered instead
+	return codepoint != '?' ? getGlyph('?') : nullptr;
+}
+
+const GlyphAtlas::Glyph* TextRenderer::insertGlyph(char32_t codepoint)
+{
+	std::optional<FontData::Glyph> glyph;
+
+	try
+	{
+		if (!rasterizer)
+			rasterizer = std::make_unique<FontRasterizer>(fontFile, rasterSize.x, rasterSize.y, mode);
+
+		glyph = rasterizer->rasterize(codepoint);
+	}
+	catch (const std::runtime_error&) {}
+
+	if (!glyph)
+	{
+		atlas.markMissing(codepoint);
+		return nullptr;
+	}
+
+	const GlyphAtlas::Glyph* inserted = atlas.insert(codepoint, *glyph);
+
+	if (inserted == nullptr)
+	{
+		// quads batched so far may use glyphs of the evicted page, they
+		// are drawn before
+		flush();
+		atlas.evictPage();
+
+		// still nullptr if the glyph is larger than a page
+		inserted = atlas.insert(codepoint, *glyph);
+	}
+
+	return inserted;
+}
+
+GLuint TextRenderer::packColor(glm::vec3 color)
+{
+	glm::vec3 clampedColor = glm::clamp(color, glm::vec3(0.0f), glm::vec3(1.0f)) * 255.0f + 0.5f;
+
+	return
+		static_cast<GLuint>(clampedColor.x) |
+		static_cast<GLuint>(clampedColor.y) << 8 |
+		static_cast<GLuint>(clampedColor.z) << 16 |
+		0xFFu << 24;
+}
+
+void TextRenderer::shapeGlyph(const GlyphAtlas::Glyph& glyph, GLfloat& x, GLfloat y, GLfloat scale, GLuint color, Vertex* quad) const
+{
+	scale *= glyphScale;
+
+	GLfloat xPos = x + glyph.bearing.x * scale;
+	GLfloat yPos = y - (glyph.size.y - glyph.bearing.y) * scale;
+
+	GLfloat w = glyph.size.x * scale;
+	GLfloat h = glyph.size.y * scale;
+
+	// positions, texture coordinates and color
+	GLfloat page = static_cast<GLfloat>(glyph.page);
+
+	quad[0] = { glm::vec2(xPos,     yPos),     glm::vec3(glyph.uvMin.x, glyph.uvMax.y, page), color };	// top left
+	quad[1] = { glm::vec2(xPos + w, yPos),     glm::vec3(glyph.uvMax.x, glyph.uvMax.y, page), color };	// top right
+	quad[2] = { glm::vec2(xPos,     yPos + h), glm::vec3(glyph.uvMin.x, glyph.uvMin.y, page), color };	// bottom left
+	quad[3] = { glm::vec2(xPos + w, yPos + h), glm::vec3(glyph.uvMax.x, glyph.uvMin.y, page), color };	// bottom right
+
+	// move cursors to next glyph; advance is measured in 1/64 pixels, divide
+	// by 64 to get advance in pixels (whole pixels for bitmaps, so they
+	// aren't filtered)
+	if (mode == FontData::SDF)
+		x += glyph.advance / 64.0f * scale;
+	else
+		x += (glyph.advance >> 6) * scale;
+}
+
+void TextRenderer::setupVertexAttributes()
+{
+	glVertexAttribPointer(
+		0, 2, GL_FLOAT, GL_FALSE,
+		sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, position))
+	);
+	glEnableVertexAttribArray(0);
+
+	glVertexAttribPointer(
+		1, 3, GL_FLOAT, GL_FALSE,
+		sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, texCoords))
+	);
+	glEnableVertexAttribArray(1);
+
+	glVertexAttribPointer(
+		2, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+		sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, color))
+	);
+	glEnableVertexAttribArray(2);
 }
 
 unsigned int TextRenderer::getDefaultWidth() const
@@ -369,10 +715,17 @@ int TextRenderer::getMaxBearingY() const
 }
 void TextRenderer::deleteGLObjects()
 {
-	for (std::pair<const char, Char>& entry : chars)
-		glDeleteTextures(1, &entry.second.texture);
+	for (GLsync& fence : fences)
+	{
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	// deleting the buffer unmaps it
+	mapping = nullptr;
 
-	glDeleteBuffers(1, &EBO);
+	GLHandlePool::release(GLHandlePool::BUFFER, EBO);
 	glDeleteBuffers(1, &VBO);
-	glDeleteVertexArrays(1, &VAO);
+	GLHandlePool::release(GLHandlePool::VERTEX_ARRAY, VAO);
+	gpuMemory = GPUMemory::Allocation();
 }
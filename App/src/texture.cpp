@@ -1,5 +1,13 @@
 #include "texture.h"
-#include "image.h"
+#include "textureData.h"
+#include "assetRegistry.h"
+#include "assetPack.h"
+#include "trace.h"
+#include "glStatistics.h"
+#include "startupReport.h"
+#include "allocationTracker.h"
+#include "glHandlePool.h"
+#include "gpuMemory.h"
 
 
 Texture::Texture(
@@ -8,29 +16,71 @@ Texture::Texture(
 )
 	: id{ 0 }
 	, name{ name }
+	, memorySize{ 0 }
+	, skippedLevels{ 0 }
 {
-	Image image;
-	if (!image.readFile(path))
+	TRACE_SCOPE("load texture", path.string());
+	ALLOCATION_SCOPE("texture load");
+
+	// a missing or broken image results in an empty texture
+	TextureData data;
+	try { data = TextureData::load(path); }
+	catch (const std::runtime_error&) {}
+
+	StartupReport::AssetScope report("texture", path, StartupReport::UPLOAD);
+
+	id = GLHandlePool::acquire(GLHandlePool::TEXTURE);
+	glBindTexture(GL_TEXTURE_2D, id);
+	GLStatistics::count(GLStatistics::STATE_CHANGES);
+
+	// over the video memory budget, the largest levels of a cooked mip chain
+	// are left out until the rest fits (the smallest one is always loaded)
+	std::size_t firstLevel = 0;
+
+	if (data.levels.size() > 1)
 	{
-		std::string error = image.getErrorStr();
+		std::uint64_t size = 0;
+		for (const TextureData::Level& level : data.levels)
+			size += level.pixels.size();
+
+		while (firstLevel + 1 < data.levels.size() && !GPUMemory::fits(size))
+		{
+			size -= data.levels[firstLevel].pixels.size();
+			firstLevel++;
+		}
 	}
 
-	image.flip();
+	skippedLevels = static_cast<unsigned int>(firstLevel);
 
-	glGenTextures(1, &id);
-	glBindTexture(GL_TEXTURE_2D, id);
-	glTexImage2D(
-		GL_TEXTURE_2D,
-		0,
-		GL_RGBA,
-		image.getWidth(),
-		image.getHeight(),
-		0,
-		image.getFormat(),
-		image.getType(),
-		image.getData()
-	);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	for (std::size_t i = firstLevel; i < data.levels.size(); i++)
+	{
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			static_cast<GLint>(i - firstLevel),
+			GL_RGBA,
+			data.levels[i].width,
+			data.levels[i].height,
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			data.levels[i].pixels.data()
+		);
+
+		memorySize += data.levels[i].pixels.size();
+
+		GLStatistics::count(GLStatistics::TEXTURE_UPLOADS);
+		GLStatistics::count(GLStatistics::TEXTURE_BYTES, data.levels[i].pixels.size());
+	}
+
+	// cooked textures come with their full mip chain, a generated one adds
+	// about a third to the size of the base level
+	if (data.levels.size() == 1)
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+		memorySize += memorySize / 3;
+	}
+
+	gpuMemory = GPUMemory::Allocation(GPUMemory::TEXTURES, memorySize);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -43,30 +93,55 @@ Texture::Texture(
 Texture::Texture(Texture&& other) noexcept
 	: id{ other.id }
 	, name{ std::move(other.name) }
+	, memorySize{ other.memorySize }
+	, skippedLevels{ other.skippedLevels }
+	, gpuMemory{ std::move(other.gpuMemory) }
 {
 	other.id = 0;
+	other.memorySize = 0;
+	other.skippedLevels = 0;
 }
 
 Texture::~Texture()
 {
-	glDeleteTextures(1, &id);
+	GLHandlePool::release(GLHandlePool::TEXTURE, id);
 }
 
 Texture& Texture::operator=(Texture&& other) noexcept
 {
 	if (this != &other)
 	{
-		glDeleteTextures(1, &id);
+		GLHandlePool::release(GLHandlePool::TEXTURE, id);
 
 		id = other.id;
 		name = std::move(other.name);
+		memorySize = other.memorySize;
+		skippedLevels = other.skippedLevels;
+		gpuMemory = std::move(other.gpuMemory);
 
 		other.id = 0;
+		other.memorySize = 0;
+		other.skippedLevels = 0;
 	}
 
 	return *this;
 }
 
+std::shared_ptr<Texture> Texture::load(
+	const std::filesystem::path& path,
+	const std::string& name
+)
+{
+	// the name is how a mesh uses the texture (diffuse, specular, ...), so
+	// the same file used in different ways results in different textures
+	return AssetRegistry::acquire<Texture>(
+		AssetRegistry::TEXTURE,
+		AssetPack::normalize(path) + "#" + name,
+		AssetRegistry::contentHash(path),
+		[&]() { return std::make_shared<Texture>(path, name); }
+	);
+}
+
 GLuint Texture::getId() const
 {
 	return id;
@@ -76,3 +151,13 @@ const std::string& Texture::getName() const
 {
 	return name;
 }
+
+std::size_t Texture::getMemorySize() const
+{
+	return memorySize;
+}
+
+unsigned int Texture::getSkippedLevels() const
+{
+	return skippedLevels;
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "textureData.h"
+#include "binaryStream.h"
+#include "derivedDataCache.h"
+#include "assets.h"
+#include "image.h"
+#include "trace.h"
+#include "startupReport.h"
+
+
+TextureData TextureData::load(const std::filesystem::path& path)
+{
+	TRACE_SCOPE("read texture", path.string());
+	StartupReport::AssetScope report("texture", path, StartupReport::IO);
+
+	FileView source = Assets::open(path, FileView::SEQUENTIAL);
+	std::uint64_t key = DerivedDataCache::key(source, params());
+
+	if (std::optional<FileView> cooked = DerivedDataCache::load(key, "texture"))
+	{
+		report.next(StartupReport::DECODE);
+		if (std::optional<TextureData> data = tryDeserialize(*cooked))
+			return std::move(*data);
+
+		DerivedDataCache::reject("texture");
+	}
+
+	// decoded like the cooker does, so the next run hits the cache
+	report.next(StartupReport::DECODE);
+	TextureData data = decode(path, true);
+
+	report.next(StartupReport::IO);
+	try { DerivedDataCache::store(key, "texture", data.serialize()); }
+	catch (const std::runtime_error&) {}
+
+	return data;
+}
+
+TextureData TextureData::decode(const std::filesystem::path& path, bool generateMips)
+{
+	// DevIL keeps global state (bound image, error), so decoding
+	// is serialized when textures are cooked on several threads
+	static std::mutex devilMutex;
+
+	Level level;
+
+	{
+		std::lock_guard<std::mutex> lock(devilMutex);
+
+		Image image;
+		if (!image.readFile(path) ||
+			!image.flip() ||
+			!image.convert(IL_RGBA, IL_UNSIGNED_BYTE))
+		{
+			std::stringstream errorMessage;
+			errorMessage
+				<< "Error: TextureData::decode(): Decoding "
+				<< path << " failed with: " << image.getErrorStr() << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+
+		level.width = image.getWidth();
+		level.height = image.getHeight();
+		level.pixels.assign(image.getData(), image.getData() + image.getSize());
+	}
+
+	TextureData data;
+	data.levels.push_back(std::move(level));
+
+	if (generateMips)
+	{
+		while (data.levels.back().width > 1 || data.levels.back().height > 1)
+			data.levels.push_back(downsample(data.levels.back()));
+	}
+
+	return data;
+}
+
+std::vector<std::byte> TextureData::serialize() const
+{
+	BinaryWriter writer;
+
+	writer.write<std::uint32_t>(formatVersion);
+	writer.write<std::uint64_t>(levels.size());
+
+	for (const Level& level : levels)
+	{
+		writer.write<GLuint>(level.width);
+		writer.write<GLuint>(level.height);
+		writer.writeVector(level.pixels);
+	}
+
+	return std::move(writer.data());
+}
+
+TextureData TextureData::deserialize(const FileView& view)
+{
+	TextureData data;
+	BinaryReader reader(view.data(), view.size());
+
+	if (reader.read<std::uint32_t>() != formatVersion)
+		throw std::runtime_error("Error: TextureData::deserialize(): Unsupported format version.\n");
+
+	// width, height and pixel count
+	data.levels.resize(reader.readCount(2 * sizeof(GLuint) + sizeof(std::uint64_t)));
+
+	for (Level& level : data.levels)
+	{
+		level.width = reader.read<GLuint>();
+		level.height = reader.read<GLuint>();
+		level.pixels = reader.readVector<std::uint8_t>();
+
+		if (level.pixels.size() != std::size_t(level.width) * level.height * 4)
+			throw std::runtime_error("Error: TextureData::deserialize(): Level size mismatch.\n");
+	}
+
+	return data;
+}
+
+std::optional<TextureData> TextureData::tryDeserialize(const FileView& view)
+{
+	// a corrupt entry is decoded again
+	try { return deserialize(view); }
+	catch (const std::runtime_error&) {}
+	catch (const std::bad_alloc&) {}
+	catch (const std::length_error&) {}
+
+	return std::nullopt;
+}
+
+std::string TextureData::params()
+{
+	std::stringstream params;
+	params << "texture;v" << formatVersion << ";rgba8;flipped;mips";
+	return params.str();
+}
+
+TextureData::Level TextureData::downsample(const Level& level)
+{
+	Level result;
+	result.width = std::max(level.width / 2, 1u);
+	result.height = std::max(level.height / 2, 1u);
+	result.pixels.resize(std::size_t(result.width) * result.height * 4);
+
+	for (GLuint y = 0; y < result.height; y++)
+	{
+		// odd sizes: the last row/column is clamped to the edge
+		GLuint y0 = std::min(2 * y, level.height - 1);
+		GLuint y1 = std::min(2 * y + 1, level.height - 1);
+
+		for (GLuint x = 0; x < result.width; x++)
+		{
+			GLuint x0 = std::min(2 * x, level.width - 1);
+			GLuint x1 = std::min(2 * x + 1, level.width - 1);
+
+			for (GLuint c = 0; c < 4; c++)
+			{
+				unsigned int sum =
+					level.pixels[(std::size_t(y0) * level.width + x0) * 4 + c] +
+					level.pixels[(std::size_t(y0) * level.width + x1) * 4 + c] +
+					level.pixels[(std::size_t(y1) * level.width + x0) * 4 + c] +
+					level.pixels[(std::size_t(y1) * level.width + x1) * 4 + c];
+
+				result.pixels[(std::size_t(y) * result.width + x) * 4 + c] =
+					static_cast<std::uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+
+	return result;
+}
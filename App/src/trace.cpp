@@ -0,0 +1,286 @@
+#ifdef APP_ENABLE_TRACING
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include "trace.h"
+#include "json.h"
+
+
+struct Trace::Event
+{
+	std::uint64_t time;	// nanoseconds since the recorder started
+	const char* name;
+	std::uint32_t thread;
+	char phase;			// B(egin), E(nd) or I(nstant), as in the trace format
+	char argument[argumentSize];
+};
+
+// written by its thread only; buffers of threads that ended are reused by
+// new threads, so the number of buffers is bounded by the number of threads
+// alive at the same time
+struct Trace::ThreadBuffer
+{
+	std::unique_ptr<Event[]> events = std::make_unique<Event[]>(eventsPerThread);
+	std::atomic<std::uint64_t> head = 0;
+	std::atomic<std::uint32_t> thread = 0;
+	std::atomic<const char*> name = nullptr;
+	std::atomic<bool> retired = false;
+};
+
+const Trace::Clock::time_point Trace::startTime = Trace::Clock::now();
+
+std::mutex Trace::mutex;
+std::vector<std::shared_ptr<Trace::ThreadBuffer>> Trace::buffers;
+std::uint32_t Trace::nextThread = 1;
+std::vector<std::pair<std::uint32_t, const char*>> Trace::threadNames;
+
+double Trace::hitchThreshold = 0.0;
+std::filesystem::path Trace::outputDirectory = ".";
+
+Trace::Clock::time_point Trace::lastFrame = Trace::Clock::now();
+Trace::Clock::time_point Trace::lastDump;
+bool Trace::dumpedHitch = false;
+std::uint64_t Trace::frameNumber = 0;
+
+void Trace::begin(const char* name, std::string_view argument)
+{
+	record('B', name, argument);
+}
+
+void Trace::end()
+{
+	record('E', nullptr, {});
+}
+
+void Trace::instant(const char* name, std::string_view argument)
+{
+	record('I', name, argument);
+}
+
+void Trace::frame()
+{
+	Clock::time_point currentTime = Clock::now();
+	double milliseconds = std::chrono::duration<double, std::milli>(currentTime - lastFrame).count();
+	lastFrame = currentTime;
+
+	record('I', "frame", std::to_string(frameNumber++));
+
+	double threshold;
+	std::filesystem::path directory;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		threshold = hitchThreshold;
+		directory = outputDirectory;
+	}
+
+	// writing the dump makes the next frame slow as well
+	if (threshold <= 0.0 || milliseconds <= threshold ||
+		(dumpedHitch && currentTime - lastDump < std::chrono::duration<double>(hitchCooldown)))
+		return;
+
+	lastDump = currentTime;
+	dumpedHitch = true;
+
+	std::filesystem::path path = directory / ("hitch_" + std::to_string(frameNumber - 1) + ".json");
+	if (dump(path))
+	{
+		std::cout
+			<< "Info: Trace: frame " << frameNumber - 1 << " took " << milliseconds
+			<< " ms, trace written to " << path << std::endl;
+	}
+}
+
+void Trace::setHitchThreshold(double milliseconds)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	hitchThreshold = milliseconds;
+}
+
+void Trace::setOutputDirectory(const std::filesystem::path& directory)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	outputDirectory = directory;
+}
+
+void Trace::setThreadName(const char* name)
+{
+	ThreadBuffer& buffer = getBuffer();
+	buffer.name.store(name, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	threadNames.push_back({ buffer.thread.load(std::memory_order_relaxed), name });
+}
+
+bool Trace::dump(const std::filesystem::path& path)
+{
+	std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+	std::vector<std::pair<std::uint32_t, const char*>> names;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		snapshot = buffers;
+		names = threadNames;
+	}
+
+	std::vector<Event> events;
+
+	for (const std::shared_ptr<ThreadBuffer>& pointer : snapshot)
+	{
+		ThreadBuffer& buffer = *pointer;
+
+		std::uint64_t head = buffer.head.load(std::memory_order_acquire);
+		std::uint64_t first = head > eventsPerThread ? head - eventsPerThread : 0;
+
+		std::size_t offset = events.size();
+		for (std::uint64_t i = first; i < head; i++)
+			events.push_back(buffer.events[i % eventsPerThread]);
+
+		// events the thread overwrote while they were copied (and the one it
+		// may be writing right now) are dropped
+		std::uint64_t newHead = buffer.head.load(std::memory_order_acquire);
+		if (newHead >= eventsPerThread && newHead - eventsPerThread + 1 > first)
+		{
+			std::uint64_t overwritten = std::min(newHead - eventsPerThread + 1, head) - first;
+			events.erase(events.begin() + offset, events.begin() + offset + overwritten);
+		}
+	}
+
+	std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b)
+	{
+		return a.time < b.time;
+	});
+
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool firstEvent = true;
+	for (const auto& [thread, name] : names)
+	{
+		file
+			<< (firstEvent ? "" : ",\n")
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+			<< ",\"args\":{\"name\":\"";
+		writeJsonEscaped(file, name);
+		file << "\"}}";
+
+		firstEvent = false;
+	}
+
+	for (const Event& event : events)
+	{
+		file
+			<< (firstEvent ? "" : ",\n")
+			<< "{\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << event.thread
+			<< ",\"ts\":" << event.time / 1000 << "." << std::setfill('0') << std::setw(3) << event.time % 1000;
+
+		if (event.name != nullptr)
+		{
+			file << ",\"name\":\"";
+			writeJsonEscaped(file, event.name);
+			file << "\"";
+		}
+
+		// frame boundaries are drawn across all threads
+		if (event.phase == 'I')
+			file << ",\"s\":\"" << (std::string_view(event.name) == "frame" ? 'g' : 't') << "\"";
+
+		if (event.argument[0] != '\0')
+		{
+			file << ",\"args\":{\"detail\":\"";
+			writeJsonEscaped(file, event.argument);
+			file << "\"}";
+		}
+
+		file << "}";
+		firstEvent = false;
+	}
+
+	file << "\n]}\n";
+
+	return static_cast<bool>(file);
+}
+
+Trace::Scope::Scope(const char* name, std::string_view argument)
+{
+	begin(name, argument);
+}
+
+Trace::Scope::~Scope()
+{
+	end();
+}
+
+Trace::ThreadBuffer& Trace::getBuffer()
+{
+	// marks the buffer as reusable when the thread ends
+	struct Holder
+	{
+		std::shared_ptr<ThreadBuffer> buffer;
+
+		~Holder()
+		{
+			if (buffer)
+				buffer->retired.store(true, std::memory_order_release);
+		}
+	};
+
+	thread_local Holder holder;
+
+	if (!holder.buffer)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (const std::shared_ptr<ThreadBuffer>& buffer : buffers)
+		{
+			if (buffer->retired.load(std::memory_order_acquire))
+			{
+				holder.buffer = buffer;
+				break;
+			}
+		}
+
+		if (!holder.buffer)
+		{
+			holder.buffer = std::make_shared<ThreadBuffer>();
+			buffers.push_back(holder.buffer);
+		}
+
+		// the events of the previous thread keep their thread id
+		holder.buffer->thread.store(nextThread++, std::memory_order_relaxed);
+		holder.buffer->name.store(nullptr, std::memory_order_relaxed);
+		holder.buffer->retired.store(false, std::memory_order_relaxed);
+	}
+
+	return *holder.buffer;
+}
+
+void Trace::record(char phase, const char* name, std::string_view argument)
+{
+	ThreadBuffer& buffer = getBuffer();
+
+	std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	Event& event = buffer.events[head % eventsPerThread];
+
+	event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count();
+	event.name = name;
+	event.thread = buffer.thread.load(std::memory_order_relaxed);
+	event.phase = phase;
+
+	// the end of a path tells more than its beginning
+	if (argument.size() >= argumentSize)
+		argument = argument.substr(argument.size() - (argumentSize - 1));
+
+	std::copy(argument.begin(), argument.end(), event.argument);
+	event.argument[argument.size()] = '\0';
+
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+#endif
@@ -5,18 +5,26 @@
 #include <GL/glew.h>
 
 #include "window.h"
+#include "startupReport.h"
+#include "frameArena.h"
+#include "glHandlePool.h"
 
 
 int Window::instanceCount = 0;
 
 Window::Window(
 	int width, int height, const std::string& title,
-	bool resizable, bool debugContext
+	bool resizable, bool debugContext, bool headless
 )
 	: window{ nullptr }
 	, width {width }, height{ height }
+	, headless{ headless }
+	, framebuffer{ 0 }, colorBuffer{ 0 }, depthBuffer{ 0 }
 	, previousTime{ 0.0 }, deltaTime{ 0.0 }
 	, fps{ 0 }
+	, time{ 0.0 }, frameTime{ 0.0 }, frame{ 0 }
+	, recording{ nullptr }, replay{ nullptr }, replayTimestep{ 0.0 }, replayEvent{ 0 }
+	, fpsStartTime{ 0.0 }, fpsFrameCount{ 0 }
 	, keys{}
 	, cursorPosX{ 0.0 }, cursorPosY{ 0.0 }
 	, scrollOffsetX{ 0.0 }, scrollOffsetY{ 0.0 }
@@ -24,6 +32,13 @@ Window::Window(
 	std::stringstream errorMessage;
 	errorMessage << "Error: Window::Window(): ";
 
+	// the platform can only be chosen before GLFW is initialized, the null
+	// platform doesn't need a display
+#if GLFW_VERSION_MAJOR > 3 || GLFW_VERSION_MINOR >= 4
+	if (instanceCount == 0)
+		glfwInitHint(GLFW_PLATFORM, headless ? GLFW_PLATFORM_NULL : GLFW_ANY_PLATFORM);
+#endif
+
 	// initialize GLFW
 	if (glfwInit() == GLFW_FALSE)
 	{
@@ -34,13 +49,18 @@ Window::Window(
 	glfwSetErrorCallback(errorCallback);
 
 	// set GLFW options
+	glfwDefaultWindowHints();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debugContext);
 	glfwWindowHint(GLFW_RESIZABLE, resizable);
 
 	// create window
-	window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
+	if (headless)
+		window = createHeadlessWindow(title);
+	else
+		window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
+
 	if (window == nullptr)
 	{
 		if (instanceCount == 0)
@@ -64,7 +84,18 @@ Window::Window(
 
 	// initialize GLEW
 	// glewExperimental = GL_TRUE;
-	if (glewInit() != GLEW_OK)
+	StartupReport::beginPhase("glew init");
+	GLenum glewResult = glewInit();
+	StartupReport::endPhase();
+
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// GLEW built for GLX fails without a GLX display, but only after the
+	// OpenGL entry points are loaded, which is all the engine needs
+	if (headless && glewResult == GLEW_ERROR_NO_GLX_DISPLAY)
+		glewResult = GLEW_OK;
+#endif
+
+	if (glewResult != GLEW_OK)
 	{
 		glfwDestroyWindow(window);
 		if (instanceCount == 0)
@@ -88,27 +119,57 @@ Window::Window(
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glEnable(GL_DEPTH_TEST);
 
+	// there is no default framebuffer to render into
+	if (headless && !createFramebuffer())
+	{
+		glfwDestroyWindow(window);
+		if (instanceCount == 0)
+			glfwTerminate();
+
+		errorMessage << "offscreen framebuffer is incomplete." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	previousTime = glfwGetTime();
+	fpsStartTime = previousTime;
+
 	instanceCount++;
 }
 
 Window::Window(Window&& other) noexcept
 	: window{ other.window }
 	, width{ other.width }, height{ other.height }
+	, headless{ other.headless }
+	, framebuffer{ other.framebuffer }, colorBuffer{ other.colorBuffer }, depthBuffer{ other.depthBuffer }
+	, framebufferMemory{ std::move(other.framebufferMemory) }
 	, previousTime{ other.previousTime }, deltaTime{ other.deltaTime }
 	, fps{ other.fps }
+	, time{ other.time }, frameTime{ other.frameTime }, frame{ other.frame }
+	, recording{ other.recording }, replay{ other.replay }
+	, replayTimestep{ other.replayTimestep }, replayEvent{ other.replayEvent }
+	, fpsStartTime{ other.fpsStartTime }, fpsFrameCount{ other.fpsFrameCount }
 	, keys{ std::move(other.keys) }
 	, cursorPosX{ other.cursorPosX }, cursorPosY{ other.cursorPosY }
 	, scrollOffsetX{ other.scrollOffsetX }, scrollOffsetY{ other.scrollOffsetY }
 {
 	other.window = nullptr;
+	other.framebuffer = 0;
+	other.colorBuffer = 0;
+	other.depthBuffer = 0;
 }
 
 Window::~Window()
 {
+	deleteFramebuffer();
+
 	instanceCount--;
 
 	if (instanceCount == 0)
+	{
+		// pooled objects belong to the context, which is gone with the last window
+		GLHandlePool::clear();
 		glfwTerminate();
+	}
 	else
 		glfwDestroyWindow(window);
 }
@@ -117,14 +178,29 @@ Window& Window::operator=(Window&& other) noexcept
 {
 	if (this != &other)
 	{
+		deleteFramebuffer();
 		glfwDestroyWindow(window);
 
 		window = other.window;
 		width = other.width;
 		height = other.height;
+		headless = other.headless;
+		framebuffer = other.framebuffer;
+		colorBuffer = other.colorBuffer;
+		depthBuffer = other.depthBuffer;
+		framebufferMemory = std::move(other.framebufferMemory);
 		previousTime = other.previousTime;
 		deltaTime = other.deltaTime;
 		fps = other.fps;
+		time = other.time;
+		frameTime = other.frameTime;
+		frame = other.frame;
+		recording = other.recording;
+		replay = other.replay;
+		replayTimestep = other.replayTimestep;
+		replayEvent = other.replayEvent;
+		fpsStartTime = other.fpsStartTime;
+		fpsFrameCount = other.fpsFrameCount;
 		keys = std::move(other.keys);
 		cursorPosX = other.cursorPosX;
 		cursorPosY = other.cursorPosY;
@@ -132,6 +208,9 @@ Window& Window::operator=(Window&& other) noexcept
 		scrollOffsetY = other.scrollOffsetY;
 
 		other.window = nullptr;
+		other.framebuffer = 0;
+		other.colorBuffer = 0;
+		other.depthBuffer = 0;
 	}
 
 	return *this;
@@ -162,11 +241,26 @@ double Window::getDeltaTime() const
 	return deltaTime;
 }
 
+double Window::getTime() const
+{
+	return time;
+}
+
+double Window::getFrameTime() const
+{
+	return frameTime;
+}
+
 int Window::getFPS() const
 {
 	return fps;
 }
 
+bool Window::isHeadless() const
+{
+	return headless;
+}
+
 bool Window::getKeyStatus(int key) const
 {
 	return keys.at(key);
@@ -202,29 +296,172 @@ void Window::update()
 {
 	/* glfwGetTime() returns the time since glfwInit() was called in seconds.
 	 * After each frame, update() is called, which increments the frame counter
-	 * and updates the current time. When currentFrame - firstFrame >= 1.0,
+	 * and updates the current time. When currentTime - fpsStartTime >= 1.0,
 	 * 1 second has passed and the frame counter contains the number of frames
-	 * rendered in that second.
+	 * rendered in that second. The counters are members, so every window
+	 * counts its own frames.
 	 */
 
-	static double startTime = glfwGetTime();
-	static int frameCounter = 0;
-
 	double currentTime = glfwGetTime();
-	deltaTime = currentTime - previousTime;
+	frameTime = currentTime - previousTime;
 	previousTime = currentTime;
 
-	frameCounter++;
+	deltaTime = frameTime;
+	if (replay != nullptr && frame < replay->getFrameCount())
+		deltaTime = replayTimestep > 0.0 ? replayTimestep : replay->deltaTimes[frame];
+
+	time += deltaTime;
+
+	if (recording != nullptr)
+		recording->deltaTimes.push_back(deltaTime);
 
-	if (currentTime - startTime >= 1.0)
+	fpsFrameCount++;
+
+	if (currentTime - fpsStartTime >= 1.0)
 	{
-		startTime = currentTime;
-		fps = frameCounter;
-		frameCounter = 0;
+		fpsStartTime = currentTime;
+		fps = fpsFrameCount;
+		fpsFrameCount = 0;
 	}
 
-	glfwSwapBuffers(window);
+	// there is nothing to swap offscreen, the frame's commands are only
+	// submitted like a swap would
+	if (headless)
+		glFlush();
+	else
+		glfwSwapBuffers(window);
+
+	// real input still arrives while replaying, but is dropped
 	glfwPollEvents();
+
+	if (replay != nullptr)
+		replayFrame();
+
+	frame++;
+
+	// transient render data of the frame before the previous one is freed
+	FrameArena::nextFrame();
+
+	// objects released before the frames the GPU finished are reused
+	GLHandlePool::collect();
+}
+
+void Window::startRecording(InputRecording& recording)
+{
+	this->recording = &recording;
+
+	// events are stored relative to the first recorded frame
+	recording.deltaTimes.clear();
+	recording.events.clear();
+	frame = 0;
+}
+
+void Window::stopRecording()
+{
+	recording = nullptr;
+}
+
+void Window::startReplay(const InputRecording& recording, double timestep)
+{
+	replay = &recording;
+	replayTimestep = timestep;
+	replayEvent = 0;
+	frame = 0;
+	time = 0.0;
+}
+
+bool Window::isReplaying() const
+{
+	return replay != nullptr;
+}
+
+GLFWwindow* Window::createHeadlessWindow(const std::string& title)
+{
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	// Mesa only creates contexts above OpenGL 3.0 with the core profile
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	// EGL uses the GPU (or llvmpipe) without a surface, OSMesa renders in
+	// software and is the fallback where EGL isn't available
+	for (int api : { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API })
+	{
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+
+		GLFWwindow* window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
+		if (window != nullptr)
+			return window;
+	}
+
+	return nullptr;
+}
+
+bool Window::createFramebuffer()
+{
+	deleteFramebuffer();
+
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	// 4 bytes color, 4 bytes depth and stencil per pixel
+	framebufferMemory = GPUMemory::Allocation(GPUMemory::RENDER_TARGETS, static_cast<std::uint64_t>(width) * height * 8);
+
+	return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void Window::deleteFramebuffer()
+{
+	if (framebuffer == 0)
+		return;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	framebufferMemory = GPUMemory::Allocation();
+}
+
+void Window::replayFrame()
+{
+	while (replayEvent < replay->events.size() && replay->events[replayEvent].frame <= frame)
+	{
+		const InputRecording::Event& event = replay->events[replayEvent++];
+
+		switch (event.type)
+		{
+		case InputRecording::KEY:
+			keyCallback(static_cast<int>(event.x), 0, static_cast<int>(event.y), 0);
+			break;
+		case InputRecording::CURSOR_POS:
+			cursorPosCallback(event.x, event.y);
+			break;
+		case InputRecording::SCROLL:
+			scrollCallback(event.x, event.y);
+			break;
+		}
+	}
+
+	if (frame + 1 >= replay->getFrameCount())
+	{
+		replay = nullptr;
+		glfwSetWindowShouldClose(window, GLFW_TRUE);
+	}
 }
 
 void Window::addKeyCallback(std::function<void(Window*)> callback)
@@ -343,10 +580,16 @@ void Window::windowSizeCallback(int width, int height)
 	this->height = height;
 
 	glViewport(0, 0, width, height);
+
+	if (headless)
+		createFramebuffer();
 }
 
 void Window::keyCallback(int key, int scancode, int action, int mods)
 {
+	if (recording != nullptr)
+		recording->events.push_back({ frame, InputRecording::KEY, static_cast<double>(key), static_cast<double>(action) });
+
 	if (key >= 0 && key <= GLFW_KEY_LAST)
 	{
 		if (action == GLFW_PRESS)
@@ -373,6 +616,9 @@ void Window::keyCallback(int key, int scancode, int action, int mods)
 
 void Window::cursorPosCallback(double posX, double posY)
 {
+	if (recording != nullptr)
+		recording->events.push_back({ frame, InputRecording::CURSOR_POS, posX, posY });
+
 	cursorPosX = posX;
 	cursorPosY = posY;
 
@@ -382,6 +628,9 @@ void Window::cursorPosCallback(double posX, double posY)
 
 void Window::scrollCallback(double offsetX, double offsetY)
 {
+	if (recording != nullptr)
+		recording->events.push_back({ frame, InputRecording::SCROLL, offsetX, offsetY });
+
 	scrollOffsetX = offsetX;
 	scrollOffsetY = offsetY;
 
@@ -415,17 +664,28 @@ void Window::windowSizeCallback(GLFWwindow* window, int width, int height)
 void Window::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
 	Window* windowHandler = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+
+	// escape still ends a replay
+	if (windowHandler->replay != nullptr)
+	{
+		if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+			glfwSetWindowShouldClose(window, GLFW_TRUE);
+		return;
+	}
+
 	windowHandler->keyCallback(key, scancode, action, mods);
 }
 
 void Window::cursorPosCallback(GLFWwindow* window, double posX, double posY)
 {
 	Window* windowHandler = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	windowHandler->cursorPosCallback(posX, posY);
+	if (windowHandler->replay == nullptr)
+		windowHandler->cursorPosCallback(posX, posY);
 }
 
 void Window::scrollCallback(GLFWwindow* window, double offsetX, double offsetY)
 {
 	Window* windowHandler = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	windowHandler->scrollCallback(offsetX, offsetY);
+	if (windowHandler->replay == nullptr)
+		windowHandler->scrollCallback(offsetX, offsetY);
 }
@@ -0,0 +1,346 @@
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_set>
+#include <unordered_map>
+
+#include "derivedDataCache.h"
+#include "modelData.h"
+#include "textureData.h"
+#include "fontData.h"
+#include "trace.h"
+#include "fileView.h"
+#include "jobSystem.h"
+
+
+// preprocesses every model, texture and font below the given paths without
+// an OpenGL context and writes the results the runtime loaders consume;
+// outputs are keyed by the content of their sources, so only assets that
+// changed since the last run are cooked again
+//
+// usage: cooker <output dir> <root dir> <path>... [--threads <n>] [--font-size [<w>x]<h>]... [--force] [--trace <file>]
+
+struct Job
+{
+	enum Kind
+	{
+		MODEL,
+		TEXTURE,
+		FONT
+	};
+
+	Kind kind;
+	std::filesystem::path path;
+	unsigned int fontWidth;
+	unsigned int fontHeight;
+	FontData::Mode fontMode = FontData::BITMAP;
+
+	std::filesystem::path output = {};
+	bool cooked = false;
+	bool failed = false;
+};
+
+static std::mutex outputMutex;
+
+static bool cookJob(Job& job, bool force)
+{
+	TRACE_SCOPE("cook", job.path.string());
+
+	FileView source(job.path, FileView::SEQUENTIAL);
+
+	std::string params;
+	std::string kind;
+
+	switch (job.kind)
+	{
+	case Job::MODEL:
+		params = ModelData::params();
+		kind = "model";
+		break;
+	case Job::TEXTURE:
+		params = TextureData::params();
+		kind = "texture";
+		break;
+	case Job::FONT:
+		params = FontData::params(job.fontWidth, job.fontHeight, job.fontMode);
+		kind = "font";
+		break;
+	}
+
+	std::uint64_t key = DerivedDataCache::key(source, params);
+	job.output = DerivedDataCache::path(key, kind);
+
+	// models are up to date only if the files they reference are unchanged,
+	// an entry that doesn't deserialize is stale and cooked again
+	if (!force && std::filesystem::exists(job.output))
+	{
+		if (job.kind != Job::MODEL)
+			return false;
+
+		std::optional<FileView> cooked = DerivedDataCache::load(key, kind);
+		std::optional<ModelData> model = cooked ? ModelData::tryDeserialize(*cooked) : std::nullopt;
+
+		if (cooked && !model)
+			DerivedDataCache::reject(kind);
+
+		if (model && model->isUpToDate())
+			return false;
+	}
+
+	std::vector<std::byte> data;
+
+	switch (job.kind)
+	{
+	case Job::MODEL:
+		data = ModelData::import(job.path).serialize();
+		break;
+	case Job::TEXTURE:
+		data = TextureData::decode(job.path, true).serialize();
+		break;
+	case Job::FONT:
+		// the glyph ranges are jobs of the same pool, idle workers steal them
+		data = FontData::rasterize(source, job.fontWidth, job.fontHeight, job.fontMode).serialize();
+		break;
+	}
+
+	DerivedDataCache::store(key, kind, data);
+	return true;
+}
+
+int main(int argC, char* argV[])
+{
+	std::filesystem::path outputDir;
+	std::filesystem::path root;
+	std::vector<std::filesystem::path> inputs;
+	std::vector<std::pair<unsigned int, unsigned int>> fontSizes;
+	unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	bool force = false;
+	std::filesystem::path tracePath;
+
+	const std::unordered_set<std::string> modelExtensions = { ".obj", ".fbx", ".gltf", ".glb", ".dae", ".3ds", ".blend" };
+	const std::unordered_set<std::string> textureExtensions = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".tif", ".tiff" };
+	const std::unordered_set<std::string> fontExtensions = { ".ttf", ".otf" };
+
+	try
+	{
+		for (int i = 1; i < argC; i++)
+		{
+			std::string arg = argV[i];
+
+			if (arg == "--threads" && i + 1 < argC)
+				threadCount = std::max(std::stoi(argV[++i]), 1);
+			else if (arg == "--font-size" && i + 1 < argC)
+			{
+				// either <height> (width derived from height) or <width>x<height>
+				std::string size = argV[++i];
+				std::size_t separator = size.find('x');
+
+				if (separator == std::string::npos)
+					fontSizes.push_back({ 0, std::stoi(size) });
+				else
+					fontSizes.push_back({ std::stoi(size.substr(0, separator)), std::stoi(size.substr(separator + 1)) });
+			}
+			else if (arg == "--force")
+				force = true;
+			else if (arg == "--trace" && i + 1 < argC)
+				tracePath = std::filesystem::absolute(argV[++i]);
+			else if (outputDir.empty())
+				outputDir = arg;
+			else if (root.empty())
+				root = arg;
+			else
+				inputs.push_back(arg);
+		}
+
+		if (outputDir.empty() || root.empty() || inputs.empty())
+		{
+			std::cerr
+				<< "usage: cooker <output dir> <root dir> <path>... "
+				<< "[--threads <n>] [--font-size [<w>x]<h>]... [--force] [--trace <file>]" << std::endl;
+			return 1;
+		}
+
+		// the size used by the app, if nothing else is requested
+		if (fontSizes.empty())
+			fontSizes.push_back({ 0, 30 });
+
+		// assets are cooked with the paths the app uses to load them,
+		// which are relative to the root directory
+		outputDir = std::filesystem::absolute(outputDir);
+		std::filesystem::current_path(root);
+		DerivedDataCache::setDirectory(outputDir);
+
+		// outputs of this run must not evict each other, stale outputs
+		// are pruned using the manifest instead
+		DerivedDataCache::setSizeLimit(0);
+
+		std::vector<std::filesystem::path> files;
+		for (const std::filesystem::path& input : inputs)
+		{
+			if (std::filesystem::is_directory(input))
+			{
+				for (const auto& entry : std::filesystem::recursive_directory_iterator(input))
+				{
+					if (entry.is_regular_file())
+						files.push_back(entry.path());
+				}
+			}
+			else
+				files.push_back(input);
+		}
+
+		std::sort(files.begin(), files.end());
+
+		std::vector<Job> jobs;
+		for (const std::filesystem::path& file : files)
+		{
+			std::string extension = file.extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(),
+				[](unsigned char c) { return static_cast<char>(std::tolower(c)); }
+			);
+
+			if (modelExtensions.contains(extension))
+				jobs.push_back({ Job::MODEL, file, 0, 0 });
+			else if (textureExtensions.contains(extension))
+				jobs.push_back({ Job::TEXTURE, file, 0, 0 });
+			else if (fontExtensions.contains(extension))
+			{
+				for (const std::pair<unsigned int, unsigned int>& size : fontSizes)
+					jobs.push_back({ Job::FONT, file, size.first, size.second });
+
+				// the distance field serves all sizes
+				jobs.push_back({ Job::FONT, file, 0, FontData::sdfSize, FontData::SDF });
+			}
+		}
+
+		auto startTime = std::chrono::steady_clock::now();
+
+		// every asset is a job, the main thread cooks as well (alone with
+		// --threads 1, jobs run on the calling thread without the pool)
+		if (threadCount > 1)
+			JobSystem::start(threadCount - 1);
+
+		JobSystem::parallelFor(jobs.size(), 1, [&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t i = first; i < last; i++)
+			{
+				Job& job = jobs[i];
+
+				try { job.cooked = cookJob(job, force); }
+				catch (const std::exception& e)
+				{
+					job.failed = true;
+
+					std::lock_guard<std::mutex> lock(outputMutex);
+					std::cerr << "Error: cooker: " << job.path << ": " << e.what();
+					continue;
+				}
+
+				if (job.cooked)
+				{
+					std::lock_guard<std::mutex> lock(outputMutex);
+					std::cout << "Info: cooker: " << job.path << " -> " << job.output.filename() << std::endl;
+				}
+			}
+		});
+
+		JobSystem::stop();
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		// the manifest lists every output of this run, outputs of previous
+		// runs that are not listed belong to sources that changed or vanished
+		std::unordered_set<std::string> outputs;
+		std::size_t cookedCount = 0;
+		std::size_t failedCount = 0;
+
+		// outputs of the previous run by source ("<output> <source>" lines)
+		std::unordered_multimap<std::string, std::string> previousOutputs;
+		{
+			std::ifstream previousManifest(outputDir / "manifest.txt");
+			std::string line;
+
+			while (std::getline(previousManifest, line))
+			{
+				std::size_t separator = line.find(' ');
+				if (separator != std::string::npos)
+					previousOutputs.emplace(line.substr(separator + 1), line.substr(0, separator));
+			}
+		}
+
+		std::filesystem::create_directories(outputDir);
+		std::ofstream manifest(outputDir / "manifest.txt", std::ios::trunc);
+
+		for (const Job& job : jobs)
+		{
+			std::string source = job.path.generic_string();
+
+			// the outputs the source had before are kept (and stay listed)
+			// when it fails to cook now, whatever they hold is still better
+			// than nothing; the output for the new key is only set once the
+			// source could be read
+			if (job.failed)
+			{
+				failedCount++;
+
+				auto [first, last] = previousOutputs.equal_range(source);
+				for (auto it = first; it != last; it++)
+				{
+					if (outputs.insert(it->second).second)
+						manifest << it->second << " " << source << "\n";
+				}
+
+				if (!job.output.empty())
+					outputs.insert(job.output.filename().string());
+
+				continue;
+			}
+
+			if (job.cooked)
+				cookedCount++;
+
+			if (outputs.insert(job.output.filename().string()).second)
+				manifest << job.output.filename().string() << " " << source << "\n";
+		}
+
+		for (const auto& entry : std::filesystem::directory_iterator(outputDir))
+		{
+			std::string extension = entry.path().extension().string();
+
+			if (entry.is_regular_file() &&
+				(extension == ".model" || extension == ".texture" || extension == ".font") &&
+				!outputs.contains(entry.path().filename().string()))
+				std::filesystem::remove(entry.path());
+		}
+
+		std::cout
+			<< "Info: cooker: " << jobs.size() << " assets, "
+			<< cookedCount << " cooked, "
+			<< jobs.size() - cookedCount - failedCount << " up to date, "
+			<< failedCount << " failed ("
+			<< threadCount << " threads, " << seconds << " s)." << std::endl;
+
+		DerivedDataCache::printStatistics(std::cout);
+
+		// timeline of all jobs on all worker threads
+#ifdef APP_ENABLE_TRACING
+		if (!tracePath.empty() && !Trace::dump(tracePath))
+			std::cerr << "Error: cooker: Writing trace " << tracePath << " failed." << std::endl;
+#endif
+
+		return failedCount > 0 ? 1 : 0;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what();
+		return 1;
+	}
+}
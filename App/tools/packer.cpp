@@ -0,0 +1,87 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "assetPack.h"
+#include "compression.h"
+
+
+// builds an asset pack from files and directories given relative to a root
+// directory, the paths inside the pack are the paths relative to that root;
+// --root switches the root directory for all following paths
+//
+// usage: packer <pack file> <root dir> <path>... [--root <dir> <path>...]... [--codec none|lz4|zstd] [--level <n>]
+int main(int argC, char* argV[])
+{
+	std::filesystem::path packPath;
+	std::filesystem::path root;
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>> inputs;
+	Compression::Codec codec = Compression::ZSTD;
+	int level = 0;
+
+	try
+	{
+		for (int i = 1; i < argC; i++)
+		{
+			std::string arg = argV[i];
+
+			if (arg == "--codec" && i + 1 < argC)
+				codec = Compression::fromString(argV[++i]);
+			else if (arg == "--level" && i + 1 < argC)
+				level = std::stoi(argV[++i]);
+			else if (arg == "--root" && i + 1 < argC)
+				root = argV[++i];
+			else if (packPath.empty())
+				packPath = arg;
+			else if (root.empty())
+				root = arg;
+			else
+				inputs.push_back({ root, arg });
+		}
+
+		if (packPath.empty() || inputs.empty())
+		{
+			std::cerr
+				<< "usage: packer <pack file> <root dir> <path>... [--root <dir> <path>...]... "
+				<< "[--codec none|lz4|zstd] [--level <n>]" << std::endl;
+			return 1;
+		}
+
+		std::vector<AssetPack::Input> files;
+		for (const auto& [inputRoot, input] : inputs)
+		{
+			std::filesystem::path path = inputRoot / input;
+
+			if (std::filesystem::is_directory(path))
+			{
+				for (const auto& entry : std::filesystem::recursive_directory_iterator(path))
+				{
+					if (entry.is_regular_file())
+						files.push_back({ entry.path(), std::filesystem::relative(entry.path(), inputRoot) });
+				}
+			}
+			else
+				files.push_back({ path, input });
+		}
+
+		// sorted input keeps the pack reproducible
+		std::sort(files.begin(), files.end(),
+			[](const AssetPack::Input& a, const AssetPack::Input& b) { return a.path < b.path; }
+		);
+
+		AssetPack::build(packPath, files, codec, level);
+
+		std::cout
+			<< "Info: packer: " << files.size() << " files written to "
+			<< packPath << " (" << Compression::toString(codec) << ")." << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what();
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,426 @@
+#include <map>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+#include "window.h"
+#include "shader.h"
+#include "camera.h"
+#include "model.h"
+#include "textRenderer.h"
+#include "derivedDataCache.h"
+#include "frameTimes.h"
+#include "allocationTracker.h"
+#include "jobSystem.h"
+#include "startupReport.h"
+
+
+// performance regression gate, every stage is a ctest test (see
+// APP_BUILD_PERF_TESTS):
+//
+//   perf_gate <stage> <baselines file> [--update]
+//
+// the stage runs headless against the bundled resources and its
+// measurements are compared with the baselines, a measurement above its
+// baseline by more than the tolerance fails the test; --update writes the
+// measurements into the baselines file instead (run it on the machine the
+// gate runs on)
+//
+// stages:
+//   model_load_cold   loading each model with an empty derived-data cache
+//   model_load_warm   loading each model again, cooked data and files cached
+//   frame_time        steady-state CPU frame time of a fixed scene
+//   peak_rss          peak resident memory after loading and drawing it
+//   hot_allocations   heap allocations per frame of the scene, aborts when
+//                     a hot scope allocates (APP_ENABLE_ALLOCATION_TRACKING)
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using Measurements = std::vector<std::pair<std::string, double>>;
+
+	const std::pair<const char*, const char*> models[] = {
+		{ "container", "resources/objects/container/container.obj" },
+		{ "lamp", "resources/objects/lamp/lamp.obj" },
+		{ "backpack", "resources/objects/backpack/backpack.obj" }
+	};
+
+	constexpr int warmLoadRuns = 5;
+	constexpr int warmupFrames = 60;
+	constexpr int measuredFrames = 600;
+
+	struct Baseline
+	{
+		double value;
+		double tolerance;	// in percent
+	};
+
+	double milliseconds(Clock::time_point begin)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+	}
+
+	double peakResidentMiB()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+
+		// kilobytes on linux, bytes on macOS
+	#ifdef __APPLE__
+		return usage.ru_maxrss / (1024.0 * 1024.0);
+	#else
+		return usage.ru_maxrss / 1024.0;
+	#endif
+#endif
+	}
+
+	// the fixed scene: the container, the lamp as the light and a line of
+	// text, seen from a camera that doesn't move
+	class Scene
+	{
+	public:
+		Scene()
+			: camera{ glm::vec3(0.0f, 1.0f, 4.0f), glm::vec3(0.0f, 0.0f, 0.0f) }
+			, mainShader{ "src/shader/main.vert", "src/shader/main.frag" }
+			, lampShader{ "src/shader/lamp.vert", "src/shader/lamp.frag" }
+			, textShader{ "src/shader/text.vert", "src/shader/textSdf.frag" }
+			, textRenderer{ "resources/font/consola.ttf", 0, 30, FontData::SDF }
+			, container{ Model::load(models[0].second) }
+			, lamp{ Model::load(models[1].second) }
+		{
+
+		}
+
+		void render(Window& window)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glm::vec3 lightPos(1.0f, 0.5f, 2.0f);
+
+			camera.applyTransformation(mainShader, window.getWidth(), window.getHeight());
+			camera.applyTransformation(lampShader, window.getWidth(), window.getHeight());
+
+			mainShader.useProgram();
+			mainShader.setUniform3f("viewPos", camera.getPosition().x, camera.getPosition().y, camera.getPosition().z);
+			mainShader.setUniform3f("light.position", lightPos.x, lightPos.y, lightPos.z);
+			mainShader.setUniform3f("light.ambient", 0.1f, 0.1f, 0.1f);
+			mainShader.setUniform3f("light.diffuse", 0.5f, 0.5f, 0.5f);
+			mainShader.setUniform3f("light.specular", 1.0f, 1.0f, 1.0f);
+			mainShader.setUniform1f("material.shininess", 64.0f);
+
+			container->draw(mainShader);
+			lamp->draw(lampShader, lightPos, 0.25f);
+
+			textRenderer.renderText(textShader, layout, "perf_gate 0123456789", 0.0f, 32.0f, TextRenderer::TOP_LEFT);
+			textRenderer.endFrame();
+
+			window.update();
+		}
+
+	private:
+		Camera camera;
+		Shader mainShader;
+		Shader lampShader;
+		Shader textShader;
+		TextRenderer textRenderer;
+		TextLayout layout;
+		std::shared_ptr<Model> container;
+		std::shared_ptr<Model> lamp;
+	};
+
+	// the models are loaded one after another, every load finishes its
+	// uploads before the next one starts
+	Measurements loadModels(const std::string& stage, int runs)
+	{
+		Measurements measurements;
+
+		for (const auto& [name, path] : models)
+		{
+			std::vector<double> times;
+
+			for (int i = 0; i < runs; i++)
+			{
+				Clock::time_point begin = Clock::now();
+				{
+					Model model(path);
+					glFinish();
+				}
+				times.push_back(milliseconds(begin));
+			}
+
+			std::sort(times.begin(), times.end());
+			measurements.push_back({ stage + "." + name + "_ms", times[times.size() / 2] });
+		}
+
+		return measurements;
+	}
+
+	Measurements runStage(const std::string& stage, Window& window)
+	{
+		if (stage == "model_load_cold")
+			return loadModels(stage, 1);
+
+		if (stage == "model_load_warm")
+		{
+			// fills the cache and the OS file cache
+			loadModels(stage, 1);
+			return loadModels(stage, warmLoadRuns);
+		}
+
+		Scene scene;
+
+		for (int i = 0; i < warmupFrames; i++)
+			scene.render(window);
+
+		if (stage == "frame_time")
+		{
+			FrameTimes frameTimes;
+			for (int i = 0; i < measuredFrames; i++)
+			{
+				scene.render(window);
+				frameTimes.add(window.getFrameTime() * 1000.0);
+			}
+
+			FrameTimes::Summary summary = frameTimes.summarize();
+			return { { "frame_time.p50_ms", summary.p50 }, { "frame_time.p99_ms", summary.p99 } };
+		}
+
+		if (stage == "peak_rss")
+			return { { "peak_rss.mib", peakResidentMiB() } };
+
+#ifdef APP_ENABLE_ALLOCATION_TRACKING
+		if (stage == "hot_allocations")
+		{
+			// glyphs and buffers are in place after the warm-up, from now on
+			// any allocation in a hot scope is a failure
+			AllocationTracker::setAssertMode(true);
+
+			double allocations = 0.0;
+			for (int i = 0; i < measuredFrames; i++)
+			{
+				scene.render(window);
+				ALLOCATION_FRAME();
+				allocations += AllocationTracker::getLastFrame().allocations;
+			}
+
+			AllocationTracker::setAssertMode(false);
+			return { { "hot_allocations.per_frame", allocations / measuredFrames } };
+		}
+#endif
+
+		std::stringstream errorMessage;
+		errorMessage << "Error: perf_gate: Unknown stage " << stage << "." << std::endl;
+		throw std::runtime_error(errorMessage.str());
+	}
+
+	// "<measurement> <baseline> <tolerance %>" per line, # starts a comment
+	std::map<std::string, Baseline> readBaselines(const std::filesystem::path& path)
+	{
+		std::map<std::string, Baseline> baselines;
+		std::ifstream file(path);
+		std::string line;
+
+		while (std::getline(file, line))
+		{
+			std::stringstream stream(line.substr(0, line.find('#')));
+			std::string name;
+			Baseline baseline{};
+
+			if (stream >> name >> baseline.value >> baseline.tolerance)
+				baselines[name] = baseline;
+		}
+
+		return baselines;
+	}
+
+	// replaces the values of the measurements, keeps everything else
+	void updateBaselines(const std::filesystem::path& path, const Measurements& measurements)
+	{
+		std::vector<std::string> lines;
+		std::ifstream input(path);
+		std::string line;
+
+		while (std::getline(input, line))
+			lines.push_back(line);
+		input.close();
+
+		for (const auto& [name, value] : measurements)
+		{
+			std::stringstream updated;
+			updated << std::fixed << std::setprecision(2) << name << " " << value << " ";
+
+			auto it = std::find_if(lines.begin(), lines.end(), [&](const std::string& line)
+			{
+				return line.compare(0, name.size() + 1, name + " ") == 0;
+			});
+
+			if (it != lines.end())
+			{
+				std::stringstream stream(*it);
+				std::string ignored;
+				double tolerance = 0.0;
+				stream >> ignored >> ignored >> tolerance;
+
+				updated << std::defaultfloat << tolerance;
+				*it = updated.str();
+			}
+			else
+			{
+				updated << 25;
+				lines.push_back(updated.str());
+			}
+		}
+
+		std::ofstream output(path, std::ios::trunc);
+		for (const std::string& line : lines)
+			output << line << "\n";
+
+		if (!output)
+		{
+			std::stringstream errorMessage;
+			errorMessage << "Error: perf_gate: Writing " << path.string() << " failed." << std::endl;
+			throw std::runtime_error(errorMessage.str());
+		}
+	}
+
+	// prints every measurement against its baseline, returns false if any
+	// exceeded its tolerance or has no baseline (a renamed measurement or a
+	// missing line must not disable the gate)
+	bool compare(const std::string& stage, const Measurements& measurements, const std::map<std::string, Baseline>& baselines)
+	{
+		bool passed = true;
+		bool missing = false;
+
+		std::cout
+			<< std::left << std::setw(32) << "measurement" << std::right
+			<< std::setw(12) << "baseline" << std::setw(12) << "measured"
+			<< std::setw(10) << "change" << std::setw(10) << "limit" << std::endl;
+
+		for (const auto& [name, value] : measurements)
+		{
+			std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2);
+
+			auto it = baselines.find(name);
+			if (it == baselines.end())
+			{
+				std::cout << std::setw(12) << "-" << std::setw(12) << value << "    NO BASELINE" << std::defaultfloat << std::endl;
+				missing = true;
+				continue;
+			}
+
+			const Baseline& baseline = it->second;
+			double change = baseline.value > 0.0 ? (value / baseline.value - 1.0) * 100.0 : 0.0;
+			bool regressed = baseline.value > 0.0 ? change > baseline.tolerance : value > 0.0;
+			passed = passed && !regressed;
+
+			std::stringstream changeColumn;
+			changeColumn << std::showpos << std::fixed << std::setprecision(1) << change << "%";
+
+			std::stringstream limitColumn;
+			limitColumn << "+" << std::fixed << std::setprecision(0) << baseline.tolerance << "%";
+
+			std::cout
+				<< std::setw(12) << baseline.value << std::setw(12) << value
+				<< std::setw(10) << changeColumn.str() << std::setw(10) << limitColumn.str();
+
+			if (regressed)
+				std::cout << "  REGRESSED";
+			else if (-change > baseline.tolerance)
+				std::cout << "  faster, update the baseline";
+
+			std::cout << std::defaultfloat << std::endl;
+		}
+
+		if (!passed)
+			std::cerr << "Error: perf_gate: " << stage << " regressed beyond its tolerance." << std::endl;
+
+		if (missing)
+		{
+			std::cerr
+				<< "Error: perf_gate: " << stage << " has measurements without a baseline, "
+				<< "add them with --update." << std::endl;
+		}
+
+		return passed && !missing;
+	}
+}
+
+int main(int argC, char* argV[])
+{
+	try
+	{
+		if (argC < 3)
+		{
+			std::cerr << "usage: perf_gate <stage> <baselines file> [--update]" << std::endl;
+			return 1;
+		}
+
+		std::string stage = argV[1];
+		std::filesystem::path baselinesPath = std::filesystem::absolute(argV[2]);
+		bool update = argC > 3 && std::string(argV[3]) == "--update";
+
+		// the stages read the loose resources, cooked data goes to a cache
+		// of their own, so the cold stage really starts cold
+		std::filesystem::path cacheDir = std::filesystem::temp_directory_path() / ("perf_gate_" + stage);
+		std::filesystem::remove_all(cacheDir);
+
+		std::filesystem::current_path(APP_PERF_SOURCE_DIR);
+		DerivedDataCache::setDirectory(cacheDir);
+
+		// the loads measured aren't part of a startup, they mustn't pay for
+		// recording it
+		StartupReport::finish();
+
+		// the stages run with the job system, like the app
+		JobSystem::start();
+
+		Measurements measurements;
+		{
+			Window window{ 800, 800, "perf_gate", false, false, true };
+			measurements = runStage(stage, window);
+		}
+
+		JobSystem::stop();
+
+		std::filesystem::remove_all(cacheDir);
+
+		if (update)
+		{
+			updateBaselines(baselinesPath, measurements);
+			std::cout << "Info: perf_gate: " << stage << " baselines written to " << baselinesPath.string() << std::endl;
+			return 0;
+		}
+
+		return compare(stage, measurements, readBaselines(baselinesPath)) ? 0 : 1;
+	}
+	catch (const std::exception& e)
+	{
+		JobSystem::stop();
+
+		std::cerr << e.what();
+		return 1;
+	}
+}